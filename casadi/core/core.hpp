@@ -33,6 +33,7 @@
 #include "polynomial.hpp"
 #include "std_vector_tools.hpp"
 #include "global_options.hpp"
+#include "profiler.hpp"
 #include "casadi_meta.hpp"
 
 // Matrices
@@ -33,6 +33,7 @@
 #include "conic.hpp"
 #include "jit.hpp"
 #include "../casadi_file.hpp"
+#include "serializer.hpp"
 
 #include <typeinfo>
 #include <fstream>
@@ -364,8 +365,15 @@ namespace casadi {
     vector<int> iw(sz_iw());
     vector<D> w(sz_w());
 
-    // Evaluate memoryless
-    (*this)(get_ptr(arg), get_ptr(res), get_ptr(iw), get_ptr(w), 0);
+    // Evaluate with a memory object of our own, allowing concurrent calls
+    int mem = checkout();
+    try {
+      (*this)(get_ptr(arg), get_ptr(res), get_ptr(iw), get_ptr(w), mem);
+    } catch(...) {
+      release(mem);
+      throw;
+    }
+    release(mem);
   }
 
 
@@ -394,8 +402,15 @@ namespace casadi {
     vector<int> iw(sz_iw());
     vector<bvec_t> w(sz_w());
 
-    // Evaluate memoryless
-    rev(get_ptr(arg), get_ptr(res), get_ptr(iw), get_ptr(w), 0);
+    // Evaluate with a memory object of our own, allowing concurrent calls
+    int mem = checkout();
+    try {
+      rev(get_ptr(arg), get_ptr(res), get_ptr(iw), get_ptr(w), mem);
+    } catch(...) {
+      release(mem);
+      throw;
+    }
+    release(mem);
   }
 
   Function Function::mapaccum(const string& name, int n, int n_accum, const Dict& opts) {
@@ -1141,6 +1156,53 @@ namespace casadi {
     return (*this)->generate_dependencies(fname, opts);
   }
 
+  // Identifies files written by Function::save, followed by a format version
+  static const char serialization_magic[] = "CASADIFN";
+  static const int serialization_version = 1;
+
+  void Function::save(const std::string& fname) const {
+    ofstream file(fname.c_str(), ios::binary);
+    casadi_assert_message(file.good(), "Function::save: Cannot open " + fname);
+    save(file);
+  }
+
+  void Function::save(std::ostream& stream) const {
+    Serializer s(stream);
+    s.write(serialization_magic, sizeof(serialization_magic)-1);
+    s.pack(serialization_version);
+    s.pack((*this)->type_name());
+    (*this)->serialize(s);
+    (*this)->serialize_jac_sparsity(s);
+  }
+
+  Function Function::load(const std::string& fname, const Dict& opts) {
+    ifstream file(fname.c_str(), ios::binary);
+    casadi_assert_message(file.good(), "Function::load: Cannot open " + fname);
+    return load(file, opts);
+  }
+
+  Function Function::load(std::istream& stream, const Dict& opts) {
+    Deserializer s(stream);
+    char magic[sizeof(serialization_magic)-1];
+    s.read(magic, sizeof(magic));
+    casadi_assert_message(equal(magic, magic+sizeof(magic), serialization_magic),
+                          "Function::load: Not a serialized function");
+    int version;
+    s.unpack(version);
+    casadi_assert_message(version==serialization_version,
+                          "Function::load: Unsupported format version " << version);
+    string type;
+    s.unpack(type);
+    Function ret;
+    if (type=="sxfunction") {
+      ret = SXFunction::deserialize(s, opts);
+    } else {
+      casadi_error("Function::load: Cannot deserialize " + type);
+    }
+    ret->deserialize_jac_sparsity(s);
+    return ret;
+  }
+
   void Function::checkInputs() const {
     return (*this)->checkInputs();
   }
@@ -1442,6 +1504,23 @@ namespace casadi {
     return (*this)->memory(ind);
   }
 
+  FunctionBuffer::FunctionBuffer(const Function& f)
+    : f_(f), n_in_(f.n_in()), n_out_(f.n_out()),
+      arg_(f.sz_arg(), 0), res_(f.sz_res(), 0), iw_(f.sz_iw()), w_(f.sz_w()) {
+    mem_ = f_.checkout();
+  }
+
+  FunctionBuffer::~FunctionBuffer() {
+    f_.release(mem_);
+  }
+
+  void FunctionBuffer::eval(const double** arg, double** res) {
+    // Pass the pointers in persistent buffers, leaving room for the function
+    copy(arg, arg+n_in_, arg_.begin());
+    copy(res, res+n_out_, res_.begin());
+    f_(get_ptr(arg_), get_ptr(res_), get_ptr(iw_), get_ptr(w_), mem_);
+  }
+
   void Function::assert_size_in(int i, int nrow, int ncol) const {
     casadi_assert_message(size1_in(i)==nrow && size2_in(i)==ncol,
                           "Incorrect shape for " << *this << " input " << i << " \""
@@ -593,7 +593,7 @@ namespace casadi {
 #endif // WITH_DEPRECATED_FEATURES
 
     /** \brief  Evaluate symbolically in parallel and sum (matrix graph)
-        \param parallelization Type of parallelization used: unroll|serial|openmp
+        \param parallelization Type of parallelization used: unroll|serial|openmp|thread|process
     */
     std::vector<MX> mapsum(const std::vector<MX > &arg,
                            const std::string& parallelization="serial");
@@ -658,7 +658,7 @@ namespace casadi {
                 s_(N-1) <- f(a_(N-1), p_(N-1))
         \endverbatim
 
-        \param parallelization Type of parallelization used: unroll|serial|openmp
+        \param parallelization Type of parallelization used: unroll|serial|openmp|thread|process
     */
     Function map(int n, const std::string& parallelization="serial");
 
@@ -789,6 +789,28 @@ namespace casadi {
     /** \brief Export / Generate C code for the dependency function */
     std::string generate_dependencies(const std::string& fname, const Dict& opts=Dict());
 
+    /** \brief Save the function to a file in a compact binary format
+
+        Stores the expression graph together with the Jacobian sparsity patterns
+        calculated so far, see Function::load. Currently supported for SX functions.
+        The format uses the native byte order of the platform.
+    */
+    void save(const std::string& fname) const;
+
+    /** \brief Load a function saved with Function::save
+
+        \param opts Options passed to the function constructor
+    */
+    static Function load(const std::string& fname, const Dict& opts=Dict());
+
+#ifndef SWIG
+    ///@{
+    /** \brief Save/load a function to/from a stream, cf. save(fname), load(fname) */
+    void save(std::ostream& stream) const;
+    static Function load(std::istream& stream, const Dict& opts=Dict());
+    ///@}
+#endif // SWIG
+
 #ifndef SWIG
     /// \cond INTERNAL
     /// Get a const pointer to the node
@@ -1022,6 +1044,56 @@ namespace casadi {
 #endif // SWIG
   };
 
+#ifndef SWIG
+  /** \brief Persistent buffers for repeated numerical evaluation of a Function
+
+      Owns a checked out memory object together with argument, result and work
+      vectors sized for the function, so that eval does not allocate. Intended for
+      evaluating the same function many times, e.g. in a real-time loop.
+      Each instance must only be used by one thread at a time.
+  */
+  class CASADI_EXPORT FunctionBuffer {
+  public:
+    /// Constructor, allocates the buffers and checks out a memory object
+    explicit FunctionBuffer(const Function& f);
+
+    /// Destructor, releases the memory object
+    ~FunctionBuffer();
+
+    /** \brief Evaluate numerically without allocating
+     *
+     * \a arg and \a res have length n_in() and n_out() respectively,
+     * null pointers are treated as in Function::operator().
+     */
+    void eval(const double** arg, double** res);
+
+    /// Access the function
+    const Function& function() const { return f_;}
+
+  private:
+    // Copying not allowed
+    FunctionBuffer(const FunctionBuffer&);
+    FunctionBuffer& operator=(const FunctionBuffer&);
+
+    /// Function being evaluated
+    Function f_;
+
+    /// Number of inputs and outputs
+    int n_in_, n_out_;
+
+    /// Argument and result pointers, length sz_arg() and sz_res()
+    std::vector<const double*> arg_;
+    std::vector<double*> res_;
+
+    /// Work vectors
+    std::vector<int> iw_;
+    std::vector<double> w_;
+
+    /// Memory object
+    int mem_;
+  };
+#endif // SWIG
+
 } // namespace casadi
 
 #include "../matrix_impl.hpp"
@@ -27,7 +27,10 @@
 #include "../mx/casadi_call.hpp"
 #include "../std_vector_tools.hpp"
 #include "../global_options.hpp"
+#include "../profiler.hpp"
+#include "../thread_pool.hpp"
 #include "external.hpp"
+#include "serializer.hpp"
 
 #include <typeinfo>
 #include <cctype>
@@ -36,10 +39,35 @@
 #include <ctime>
 #endif // WITH_DL
 #include <iomanip>
+#include <list>
+#include <cstring>
+#include <cstdint>
+#include <unordered_map>
+#include <random>
 
 using namespace std;
 
 namespace casadi {
+  /// Cached evaluations, most recently used first
+  struct FunctionMemo {
+    struct Entry {
+      // Hash of the input values
+      size_t hash;
+      // Input and output nonzeros, all inputs and outputs concatenated
+      vector<double> in, out;
+      // Outputs that have been calculated
+      vector<bool> has_out;
+    };
+    list<Entry> entries;
+    // Entries by the hash of their inputs
+    unordered_multimap<size_t, list<Entry>::iterator> index;
+    // Statistics
+    int n_hit, n_miss;
+    // Protects all of the above
+    std::mutex mtx;
+    FunctionMemo() : n_hit(0), n_miss(0) {}
+  };
+
   Dict combine(const Dict& first, const Dict& second) {
     if (first.empty()) return second;
     if (second.empty()) return first;
@@ -67,6 +95,7 @@ namespace casadi {
     ad_weight_ = 0.33; // i.e. nf <= 2*na <=> 1/3*nf <= (1-1/3)*na, forward when tie
     // Both modes equally expensive by default (no "taping" needed)
     ad_weight_sp_ = 0.49; // Forward when tie
+    hessian_coloring_ = "star";
     jac_penalty_ = 2;
     max_num_dir_ = optimized_num_dir;
     user_data_ = 0;
@@ -77,6 +106,8 @@ namespace casadi {
 
     eval_ = 0;
     simple_ = 0;
+    memoize_ = 0;
+    memo_ = 0;
 
     has_refcount_ = false;
 
@@ -91,6 +122,7 @@ namespace casadi {
   }
 
   FunctionInternal::~FunctionInternal() {
+    if (memo_) delete memo_;
     for (void* m : mem_) {
       casadi_assert_warning(m==0, "Memory object has not been properly freed");
     }
@@ -134,6 +166,11 @@ namespace casadi {
         "Weighting factor for sparsity pattern calculation calculation."
         "Overrides default behavior. Set to 0 and 1 to force forward and "
         "reverse mode respectively. Cf. option \"ad_weight\"."}},
+      {"hessian_coloring",
+       {OT_STRING,
+        "Graph coloring for symmetric Jacobians, e.g. Hessians: "
+        "\"star\" (default) with direct recovery or \"acyclic\", which needs fewer "
+        "directional derivatives but recovers the entries by substitution"}},
       {"jac_penalty",
        {OT_DOUBLE,
         "When requested for a number of forward/reverse directions,   "
@@ -183,7 +220,11 @@ namespace casadi {
         " Overrules the builtin optimized_num_dir."}},
       {"print_time",
        {OT_BOOL,
-        "print information about execution time"}}
+        "print information about execution time"}},
+      {"memoize",
+       {OT_INT,
+        "Cache the outputs of numerical evaluations for up to this many distinct "
+        "input values, discarding the least recently used. Default: 0 (disabled)"}}
      }
   };
 
@@ -220,10 +261,16 @@ namespace casadi {
         ad_weight_ = op.second;
       } else if (op.first=="ad_weight_sp") {
         ad_weight_sp_ = op.second;
+      } else if (op.first=="hessian_coloring") {
+        hessian_coloring_ = op.second.to_string();
+        casadi_assert_message(hessian_coloring_=="star" || hessian_coloring_=="acyclic",
+                              "Unknown hessian_coloring \"" + hessian_coloring_ + "\"");
       } else if (op.first=="max_num_dir") {
         max_num_dir_ = op.second;
       } else if (op.first=="print_time") {
         print_time_ = op.second;
+      } else if (op.first=="memoize") {
+        memoize_ = op.second;
       }
     }
 
@@ -268,6 +315,11 @@ namespace casadi {
 
     alloc_arg(0);
     alloc_res(0);
+
+    // Cache for numerical evaluations
+    casadi_assert_message(memoize_>=0, "Option \"memoize\" must be nonnegative");
+    if (memo_) delete memo_;
+    memo_ = memoize_>0 ? new FunctionMemo() : 0;
   }
 
   std::string FunctionInternal::get_name_in(int i) {
@@ -279,6 +331,9 @@ namespace casadi {
   }
 
   void FunctionInternal::finalize(const Dict& opts) {
+    // Load cached sparsity patterns, if any
+    if (!GlobalOptions::sparsity_cache.empty()) sp_cache_load();
+
     if (jit_) {
       string jit_name = "jit_tmp";
       if (has_codegen()) {
@@ -305,13 +360,19 @@ namespace casadi {
       }
     }
 
-    // Create memory object
+    // Create memory object, available for the first call
     int mem = checkout();
     casadi_assert(mem==0);
+    release(mem);
   }
 
   void FunctionInternal::
   _eval(const double** arg, double** res, int* iw, double* w, int mem) {
+    ProfilerScope profile(this, name_, "eval");
+
+    // Return cached result, if any
+    if (memo_ && memo_lookup(arg, res)) return;
+
     if (simplifiedCall()) {
       // Copy arguments to input buffers
       const double* arg1=w;
@@ -338,6 +399,134 @@ namespace casadi {
         eval(memory(mem), arg, res, iw, w);
       }
     }
+
+    // Cache the result
+    if (memo_) memo_store(arg, res);
+  }
+
+  // Compare doubles bitwise, consistent with the hash (NaN matches NaN)
+  static inline bool memo_equal(double a, double b) {
+    return memcmp(&a, &b, sizeof(double))==0;
+  }
+
+  // Find the cache entry matching the inputs, null if none
+  static FunctionMemo::Entry* memo_find(FunctionMemo& memo, const FunctionInternal& f,
+                                        size_t h, const double** arg) {
+    auto range = memo.index.equal_range(h);
+    for (auto it=range.first; it!=range.second; ++it) {
+      FunctionMemo::Entry& e = *it->second;
+      auto v = e.in.begin();
+      bool match = true;
+      for (int j=0; match && j<f.n_in(); ++j) {
+        for (int k=0; k<f.nnz_in(j); ++k) {
+          if (!memo_equal(*v++, arg[j] ? arg[j][k] : 0)) {
+            match = false;
+            break;
+          }
+        }
+      }
+      if (match) {
+        // Move to the front of the list
+        memo.entries.splice(memo.entries.begin(), memo.entries, it->second);
+        return &e;
+      }
+    }
+    return 0;
+  }
+
+  // Hash of the input values, null inputs are treated as zero
+  static size_t memo_hash(const FunctionInternal& f, const double** arg) {
+    size_t h = 0;
+    for (int j=0; j<f.n_in(); ++j) {
+      for (int k=0; k<f.nnz_in(j); ++k) {
+        double v = arg[j] ? arg[j][k] : 0;
+        uint64_t bits;
+        memcpy(&bits, &v, sizeof(v));
+        hash_combine(h, bits);
+      }
+    }
+    return h;
+  }
+
+  bool FunctionInternal::memo_lookup(const double** arg, double** res) const {
+    size_t h = memo_hash(*this, arg);
+    std::lock_guard<std::mutex> lock(memo_->mtx);
+    FunctionMemo::Entry* e = memo_find(*memo_, *this, h, arg);
+
+    // All requested outputs must be available
+    bool hit = e!=0;
+    for (int j=0; hit && j<n_out(); ++j) {
+      if (res[j] && !e->has_out[j]) hit = false;
+    }
+    if (!hit) {
+      memo_->n_miss++;
+      return false;
+    }
+
+    // Copy outputs
+    auto v = e->out.begin();
+    for (int j=0; j<n_out(); ++j) {
+      if (res[j]) copy_n(v, nnz_out(j), res[j]);
+      v += nnz_out(j);
+    }
+    memo_->n_hit++;
+    return true;
+  }
+
+  void FunctionInternal::memo_store(const double** arg, double** res) const {
+    size_t h = memo_hash(*this, arg);
+    std::lock_guard<std::mutex> lock(memo_->mtx);
+    FunctionMemo::Entry* e = memo_find(*memo_, *this, h, arg);
+    if (e==0) {
+      // New entry
+      memo_->entries.push_front(FunctionMemo::Entry());
+      e = &memo_->entries.front();
+      e->hash = h;
+      e->in.reserve(nnz_in());
+      for (int j=0; j<n_in(); ++j) {
+        if (arg[j]) {
+          e->in.insert(e->in.end(), arg[j], arg[j]+nnz_in(j));
+        } else {
+          e->in.resize(e->in.size()+nnz_in(j), 0);
+        }
+      }
+      e->out.resize(nnz_out());
+      e->has_out.resize(n_out(), false);
+      memo_->index.insert(make_pair(h, memo_->entries.begin()));
+
+      // Discard the least recently used entry
+      if (memo_->entries.size()>static_cast<size_t>(memoize_)) {
+        auto last = --memo_->entries.end();
+        auto range = memo_->index.equal_range(last->hash);
+        for (auto it=range.first; it!=range.second; ++it) {
+          if (it->second==last) {
+            memo_->index.erase(it);
+            break;
+          }
+        }
+        memo_->entries.erase(last);
+      }
+    }
+
+    // Store the calculated outputs
+    auto v = e->out.begin();
+    for (int j=0; j<n_out(); ++j) {
+      if (res[j]) {
+        copy_n(res[j], nnz_out(j), v);
+        e->has_out[j] = true;
+      }
+      v += nnz_out(j);
+    }
+  }
+
+  Dict FunctionInternal::_get_stats(int mem) const {
+    Dict stats = get_stats(memory(mem));
+    if (memo_) {
+      std::lock_guard<std::mutex> lock(memo_->mtx);
+      stats["n_memo_hit"] = memo_->n_hit;
+      stats["n_memo_miss"] = memo_->n_miss;
+    }
+    return stats;
   }
 
   void FunctionInternal::_eval(const SXElem** arg, SXElem** res, int* iw, SXElem* w, int mem) {
@@ -412,6 +601,7 @@ namespace casadi {
     opts["jit"] = jit_;
     opts["compiler"] = compilerplugin_;
     opts["jit_options"] = jit_options_;
+    opts["hessian_coloring"] = hessian_coloring_;
     return opts;
   }
 
@@ -533,22 +723,114 @@ namespace casadi {
   }
   /// \endcond
 
-  // Traits
-  template<bool fwd> struct JacSparsityTraits {};
-  template<> struct JacSparsityTraits<true> {
-    typedef const bvec_t* arg_t;
-    static inline void sp(FunctionInternal *f, const bvec_t** arg, bvec_t** res,
-                          int* iw, bvec_t* w, int mem) {
-      f->sp_fwd(arg, res, iw, w, mem);
+  void FunctionInternal::sp_sweeps(bool fwd, int iind, int oind, int nsweep,
+                                   const SpSeed& seed, const SpSens& sens,
+                                   std::vector<int>& jrow, std::vector<int>& jcol) {
+    if (nsweep==0) return;
+
+    // Number of sweeps propagated together in a single pass, one word per nonzero each
+    int nw = has_sp_wide() ? std::max(1, std::min(GlobalOptions::sparsity_width, nsweep)) : 1;
+    int npass = nsweep/nw;
+    if (nsweep%nw) npass++;
+
+    // Number of threads, each getting at least sp_min_work words of work vector to
+    // propagate, so that small functions stay serial
+    const long sp_min_work = 1<<16;
+    int n_threads = GlobalOptions::sparsity_threads;
+    if (n_threads<=0) n_threads = ThreadPool::default_size();
+    if (n_threads>1 && has_parallel_sp()) {
+      long work = static_cast<long>(npass-1)*nw*std::max<size_t>(sz_w(), 1);
+      n_threads = static_cast<int>(std::min<long>(n_threads, work/sp_min_work));
+    } else {
+      n_threads = 1;
+    }
+    n_threads = std::max(1, std::min(n_threads, npass-1));
+
+    // Number of seeds and sensitivities
+    int nz_seed = fwd ? nnz_in(iind) : nnz_out(oind);
+    int nz_sens = fwd ? nnz_out(oind) : nnz_in(iind);
+
+    // Evaluation buffers, seeds and sensitivities, per thread
+    struct Work {
+      vector<const bvec_t*> arg_fwd;
+      vector<bvec_t*> arg_adj, res;
+      vector<int> iw;
+      vector<bvec_t> w, seed, sens, wide_seed, wide_sens;
+    };
+    vector<Work> work(n_threads);
+    for (auto&& m : work) {
+      m.arg_fwd.resize(sz_arg(), 0);
+      m.arg_adj.resize(sz_arg(), 0);
+      m.res.resize(sz_res(), 0);
+      m.iw.resize(sz_iw());
+      m.w.resize(sz_w()*nw, 0);
+      m.seed.resize(nz_seed*nw, 0);
+      m.sens.resize(nz_sens*nw, 0);
+      if (nw>1) {
+        // Seeds and sensitivities of the sweeps interleaved
+        m.wide_seed.resize(nz_seed*nw, 0);
+        m.wide_sens.resize(nz_sens*nw, 0);
+      }
+      vector<bvec_t>& v_seed = nw>1 ? m.wide_seed : m.seed;
+      vector<bvec_t>& v_sens = nw>1 ? m.wide_sens : m.sens;
+      bvec_t* s_in = get_ptr(fwd ? v_seed : v_sens);
+      bvec_t* s_out = get_ptr(fwd ? v_sens : v_seed);
+      m.arg_fwd[iind] = m.arg_adj[iind] = s_in;
+      m.res[oind] = s_out;
+    }
+
+    // Pattern entries, per sweep
+    vector<vector<int> > jrow_s(nsweep), jcol_s(nsweep);
+
+    // Perform a pass with the buffers of a thread
+    std::function<void(int, int)> pass([&](int p, int k) {
+      Work& m = work[k];
+      int s0 = p*nw, ns = std::min(nw, nsweep-s0);
+      for (int j=0; j<ns; ++j) seed(s0+j, get_ptr(m.seed)+j*nz_seed);
+      if (nw==1) {
+        if (fwd) {
+          sp_fwd(get_ptr(m.arg_fwd), get_ptr(m.res), get_ptr(m.iw), get_ptr(m.w), 0);
+        } else {
+          fill(m.w.begin(), m.w.end(), 0);
+          sp_rev(get_ptr(m.arg_adj), get_ptr(m.res), get_ptr(m.iw), get_ptr(m.w), 0);
+        }
+      } else {
+        // Interleave the seeds, unused sweeps have zero seeds
+        for (int i=0; i<nz_seed; ++i) {
+          for (int j=0; j<nw; ++j) m.wide_seed[i*nw+j] = m.seed[j*nz_seed+i];
+        }
+        if (fwd) {
+          sp_fwd_wide(get_ptr(m.arg_fwd), get_ptr(m.res), get_ptr(m.iw), get_ptr(m.w), nw);
+        } else {
+          fill(m.w.begin(), m.w.end(), 0);
+          sp_rev_wide(get_ptr(m.arg_adj), get_ptr(m.res), get_ptr(m.iw), get_ptr(m.w), nw);
+        }
+        // Separate the sensitivities
+        for (int i=0; i<nz_sens; ++i) {
+          for (int j=0; j<ns; ++j) m.sens[j*nz_sens+i] = m.wide_sens[i*nw+j];
+        }
+        if (!fwd) fill(m.wide_sens.begin(), m.wide_sens.end(), 0);
+      }
+      for (int j=0; j<ns; ++j) {
+        sens(s0+j, get_ptr(m.seed)+j*nz_seed, get_ptr(m.sens)+j*nz_sens,
+             jrow_s[s0+j], jcol_s[s0+j]);
+      }
+    });
+
+    // The first pass is performed serially, as it may initialize data members
+    pass(0, 0);
+    if (n_threads>1) {
+      ThreadPool::shared().run(npass-1, [&](int p, int k) { pass(p+1, k);}, n_threads);
+    } else {
+      for (int p=1; p<npass; ++p) pass(p, 0);
     }
-  };
-  template<> struct JacSparsityTraits<false> {
-    typedef bvec_t* arg_t;
-    static inline void sp(FunctionInternal *f, bvec_t** arg, bvec_t** res,
-                          int* iw, bvec_t* w, int mem) {
-      f->sp_rev(arg, res, iw, w, mem);
+
+    // Collect the pattern entries
+    for (int s=0; s<nsweep; ++s) {
+      jrow.insert(jrow.end(), jrow_s[s].begin(), jrow_s[s].end());
+      jcol.insert(jcol.end(), jcol_s[s].begin(), jcol_s[s].end());
     }
-  };
+  }
 
   template<bool fwd>
   Sparsity FunctionInternal::getJacSparsityGen(int iind, int oind,
@@ -557,71 +839,46 @@ namespace casadi {
     int nz_in = nnz_in(iind);
     int nz_out = nnz_out(oind);
 
-    // Evaluation buffers
-    vector<typename JacSparsityTraits<fwd>::arg_t> arg(sz_arg(), 0);
-    vector<bvec_t*> res(sz_res(), 0);
-    vector<int> iw(sz_iw());
-    vector<bvec_t> w(sz_w(), 0);
-
-    // Seeds and sensitivities
-    vector<bvec_t> seed(nz_in, 0);
-    arg[iind] = get_ptr(seed);
-    vector<bvec_t> sens(nz_out, 0);
-    res[oind] = get_ptr(sens);
-    if (!fwd) std::swap(seed, sens);
+    // Number of seed directions and sensitivities
+    int nz_seed = fwd ? nz_in : nz_out;
+    int nz_sens = fwd ? nz_out : nz_in;
 
     // Number of forward sweeps we must make
-    int nsweep = seed.size() / bvec_size;
-    if (seed.size() % bvec_size) nsweep++;
+    int nsweep = nz_seed / bvec_size;
+    if (nz_seed % bvec_size) nsweep++;
 
     // Print
     if (verbose()) {
       userOut() << "FunctionInternal::getJacSparsityGen<" << fwd << ">: "
-                << nsweep << " sweeps needed for " << seed.size() << " directions" << endl;
+                << nsweep << " sweeps needed for " << nz_seed << " directions" << endl;
     }
 
-    // Progress
-    int progress = -10;
-
-    // Temporary vectors
-    std::vector<int> jcol, jrow;
-
     // Loop over the variables, bvec_size variables at a time
-    for (int s=0; s<nsweep; ++s) {
-
-      // Print progress
-      if (verbose()) {
-        int progress_new = (s*100)/nsweep;
-        // Print when entering a new decade
-        if (progress_new / 10 > progress / 10) {
-          progress = progress_new;
-          userOut() << progress << " %"  << endl;
-        }
-      }
-
+    SpSeed seed([&](int s, bvec_t* seed_v) {
       // Nonzero offset
       int offset = s*bvec_size;
 
       // Number of local seed directions
-      int ndir_local = seed.size()-offset;
-      ndir_local = std::min(bvec_size, ndir_local);
+      int ndir_local = std::min(bvec_size, nz_seed-offset);
 
       for (int i=0; i<ndir_local; ++i) {
-        seed[offset+i] |= bvec_t(1)<<i;
+        seed_v[offset+i] |= bvec_t(1)<<i;
       }
-
-      // Propagate the dependencies
-      JacSparsityTraits<fwd>::sp(this, get_ptr(arg), get_ptr(res), get_ptr(iw), get_ptr(w), 0);
+    });
+    SpSens sens([&](int s, bvec_t* seed_v, bvec_t* sens_v,
+                    std::vector<int>& jrow, std::vector<int>& jcol) {
+      int offset = s*bvec_size;
+      int ndir_local = std::min(bvec_size, nz_seed-offset);
 
       // Loop over the nonzeros of the output
-      for (int el=0; el<sens.size(); ++el) {
+      for (int el=0; el<nz_sens; ++el) {
 
         // Get the sparsity sensitivity
-        bvec_t spsens = sens[el];
+        bvec_t spsens = sens_v[el];
 
         if (!fwd) {
           // Clear the sensitivities for the next sweep
-          sens[el] = 0;
+          sens_v[el] = 0;
         }
 
         // If there is a dependency in any of the directions
@@ -642,9 +899,13 @@ namespace casadi {
 
       // Remove the seeds
       for (int i=0; i<ndir_local; ++i) {
-        seed[offset+i] = 0;
+        seed_v[offset+i] = 0;
       }
-    }
+    });
+
+    // Propagate the dependencies
+    std::vector<int> jcol, jrow;
+    sp_sweeps(fwd, iind, oind, nsweep, seed, sens, jrow, jcol);
 
     // Construct sparsity pattern and return
     if (!fwd) swap(jrow, jcol);
@@ -662,20 +923,6 @@ namespace casadi {
     int nz = nnz_in(iind);
     casadi_assert(nz==nnz_out(oind));
 
-    // Evaluation buffers
-    vector<const bvec_t*> arg(sz_arg(), 0);
-    vector<bvec_t*> res(sz_res(), 0);
-    vector<int> iw(sz_iw());
-    vector<bvec_t> w(sz_w());
-
-    // Seeds
-    vector<bvec_t> seed(nz, 0);
-    arg[iind] = get_ptr(seed);
-
-    // Sensitivities
-    vector<bvec_t> sens(nz, 0);
-    res[oind] = get_ptr(sens);
-
     // Sparsity triplet accumulator
     std::vector<int> jcol, jrow;
 
@@ -711,9 +958,6 @@ namespace casadi {
 
       casadi_msg("Star coloring on " << r.dim() << ": " << D.size2() << " <-> " << D.size1());
 
-      // Clear the seeds
-      fill(seed.begin(), seed.end(), 0);
-
       // Subdivide the coarse block
       for (int k=0; k<coarse.size()-1; ++k) {
         int diff = coarse[k+1]-coarse[k];
@@ -737,6 +981,11 @@ namespace casadi {
       std::vector<int> lookup_row;
       std::vector<int> lookup_value;
 
+      // Seeds (first row, last row, bit) and lookup tables, per sweep
+      std::vector<int> toggle;
+      std::vector<std::vector<int> > sweep_toggle;
+      std::vector<IM> sweep_lookup;
+
       // Loop over all coarse seed directions from the coloring
       for (int csd=0; csd<D.size2(); ++csd) {
         // The maximum number of fine blocks contained in one coarse block
@@ -778,8 +1027,9 @@ namespace casadi {
               }
 
               // Toggle on seeds
-              bvec_toggle(get_ptr(seed), fine[fci+fci_start], fine[fci+fci_start+1],
-                          bvec_i+bvec_i_mod);
+              toggle.push_back(fine[fci+fci_start]);
+              toggle.push_back(fine[fci+fci_start+1]);
+              toggle.push_back(bvec_i+bvec_i_mod);
               bvec_i_mod++;
             }
           }
@@ -789,7 +1039,7 @@ namespace casadi {
 
           // Check if bvec buffer is full
           if (bvec_i==bvec_size || csd==D.size2()-1) {
-            // Calculate sparsity for bvec_size directions at once
+            // Prepare a sweep for bvec_size directions at once
 
             // Statistics
             nsweeps+=1;
@@ -807,40 +1057,10 @@ namespace casadi {
             duplicates = sparsify(duplicates);
             lookup(duplicates.sparsity()) = -bvec_size;
 
-            // Propagate the dependencies
-            sp_fwd(get_ptr(arg), get_ptr(res), get_ptr(iw), get_ptr(w), 0);
-
-            // Temporary bit work vector
-            bvec_t spsens;
-
-            // Loop over the cols of coarse blocks
-            for (int cri=0; cri<coarse.size()-1; ++cri) {
-
-              // Loop over the cols of fine blocks within the current coarse block
-              for (int fri=fine_lookup[coarse[cri]];fri<fine_lookup[coarse[cri+1]];++fri) {
-                // Lump individual sensitivities together into fine block
-                bvec_or(get_ptr(sens), spsens, fine[fri], fine[fri+1]);
-
-                // Loop over all bvec_bits
-                for (int bvec_i=0;bvec_i<bvec_size;++bvec_i) {
-                  if (spsens & (bvec_t(1) << bvec_i)) {
-                    // if dependency is found, add it to the new sparsity pattern
-                    int ind = lookup.sparsity().get_nz(bvec_i, cri);
-                    if (ind==-1) continue;
-                    int lk = lookup->at(ind);
-                    if (lk>-bvec_size) {
-                      jrow.push_back(bvec_i+lk);
-                      jcol.push_back(fri);
-                      jrow.push_back(fri);
-                      jcol.push_back(bvec_i+lk);
-                    }
-                  }
-                }
-              }
-            }
-
-            // Clear the forward seeds/adjoint sensitivities, ready for next bvec sweep
-            fill(seed.begin(), seed.end(), 0);
+            // Save sweep, performed below
+            sweep_toggle.push_back(toggle);
+            sweep_lookup.push_back(lookup);
+            toggle.clear();
 
             // Clean lookup table
             lookup_col.clear();
@@ -858,6 +1078,49 @@ namespace casadi {
         }
       }
 
+      // Calculate sparsity for bvec_size directions at once, for each sweep
+      SpSeed seed([&](int s, bvec_t* seed_v) {
+        const std::vector<int>& t = sweep_toggle[s];
+        for (int i=0; i<t.size(); i+=3) bvec_toggle(seed_v, t[i], t[i+1], t[i+2]);
+      });
+      SpSens sens([&](int s, bvec_t* seed_v, bvec_t* sens_v,
+                      std::vector<int>& jrow, std::vector<int>& jcol) {
+        const IM& lookup = sweep_lookup[s];
+
+        // Temporary bit work vector
+        bvec_t spsens;
+
+        // Loop over the cols of coarse blocks
+        for (int cri=0; cri<coarse.size()-1; ++cri) {
+
+          // Loop over the cols of fine blocks within the current coarse block
+          for (int fri=fine_lookup[coarse[cri]];fri<fine_lookup[coarse[cri+1]];++fri) {
+            // Lump individual sensitivities together into fine block
+            bvec_or(sens_v, spsens, fine[fri], fine[fri+1]);
+
+            // Loop over all bvec_bits
+            for (int bvec_i=0;bvec_i<bvec_size;++bvec_i) {
+              if (spsens & (bvec_t(1) << bvec_i)) {
+                // if dependency is found, add it to the new sparsity pattern
+                int ind = lookup.sparsity().get_nz(bvec_i, cri);
+                if (ind==-1) continue;
+                int lk = lookup->at(ind);
+                if (lk>-bvec_size) {
+                  jrow.push_back(bvec_i+lk);
+                  jcol.push_back(fri);
+                  jrow.push_back(fri);
+                  jcol.push_back(bvec_i+lk);
+                }
+              }
+            }
+          }
+        }
+
+        // Clear the forward seeds/adjoint sensitivities, ready for next bvec sweep
+        fill(seed_v, seed_v+nz, 0);
+      });
+      sp_sweeps(true, iind, oind, sweep_toggle.size(), seed, sens, jrow, jcol);
+
       // Construct fine sparsity pattern
       r = Sparsity::triplet(fine.size()-1, fine.size()-1, jrow, jcol);
 
@@ -885,19 +1148,6 @@ namespace casadi {
     // Number of nonzero outputs
     int nz_out = nnz_out(oind);
 
-    // Seeds and sensitivities
-    vector<bvec_t> s_in(nz_in, 0);
-    vector<bvec_t> s_out(nz_out, 0);
-
-    // Evaluation buffers
-    vector<const bvec_t*> arg_fwd(sz_arg(), 0);
-    vector<bvec_t*> arg_adj(sz_arg(), 0);
-    arg_fwd[iind] = arg_adj[iind] = get_ptr(s_in);
-    vector<bvec_t*> res(sz_res(), 0);
-    res[oind] = get_ptr(s_out);
-    vector<int> iw(sz_iw());
-    vector<bvec_t> w(sz_w());
-
     // Sparsity triplet accumulator
     std::vector<int> jcol, jrow;
 
@@ -976,17 +1226,10 @@ namespace casadi {
                    << (1-sp_w)*D2.size2()*adj_cost << ")");
       }
 
-      // Get seeds and sensitivities
-      bvec_t* seed_v = use_fwd ? get_ptr(s_in) : get_ptr(s_out);
-      bvec_t* sens_v = use_fwd ? get_ptr(s_out) : get_ptr(s_in);
-
       // The number of zeros in the seed and sensitivity directions
       int nz_seed = use_fwd ? nz_in  : nz_out;
       int nz_sens = use_fwd ? nz_out : nz_in;
 
-      // Clear the seeds
-      for (int i=0; i<nz_seed; ++i) seed_v[i]=0;
-
       // Choose the active jacobian coloring scheme
       Sparsity D = use_fwd ? D1 : D2;
 
@@ -1031,6 +1274,11 @@ namespace casadi {
       std::vector<int> lookup_row;
       std::vector<int> lookup_value;
 
+      // Seeds (first row, last row, bit) and lookup tables, per sweep
+      std::vector<int> toggle;
+      std::vector<std::vector<int> > sweep_toggle;
+      std::vector<IM> sweep_lookup;
+
       // Loop over all coarse seed directions from the coloring
       for (int csd=0; csd<D.size2(); ++csd) {
 
@@ -1071,8 +1319,9 @@ namespace casadi {
               }
 
               // Toggle on seeds
-              bvec_toggle(seed_v, fine_row[fci+fci_start], fine_row[fci+fci_start+1],
-                          bvec_i+bvec_i_mod);
+              toggle.push_back(fine_row[fci+fci_start]);
+              toggle.push_back(fine_row[fci+fci_start+1]);
+              toggle.push_back(bvec_i+bvec_i_mod);
               bvec_i_mod++;
             }
           }
@@ -1082,7 +1331,7 @@ namespace casadi {
 
           // Check if bvec buffer is full
           if (bvec_i==bvec_size || csd==D.size2()-1) {
-            // Calculate sparsity for bvec_size directions at once
+            // Prepare a sweep for bvec_size directions at once
 
             // Statistics
             nsweeps+=1;
@@ -1091,47 +1340,10 @@ namespace casadi {
             IM lookup = IM::triplet(lookup_row, lookup_col, lookup_value, bvec_size,
                                     coarse_col.size());
 
-            // Propagate the dependencies
-            if (use_fwd) {
-              sp_fwd(get_ptr(arg_fwd), get_ptr(res), get_ptr(iw), get_ptr(w), 0);
-            } else {
-              fill(w.begin(), w.end(), 0);
-              sp_rev(get_ptr(arg_adj), get_ptr(res), get_ptr(iw), get_ptr(w), 0);
-            }
-
-            // Temporary bit work vector
-            bvec_t spsens;
-
-            // Loop over the cols of coarse blocks
-            for (int cri=0;cri<coarse_col.size()-1;++cri) {
-
-              // Loop over the cols of fine blocks within the current coarse block
-              for (int fri=fine_col_lookup[coarse_col[cri]];
-                   fri<fine_col_lookup[coarse_col[cri+1]];++fri) {
-                // Lump individual sensitivities together into fine block
-                bvec_or(sens_v, spsens, fine_col[fri], fine_col[fri+1]);
-
-                // Next iteration if no sparsity
-                if (!spsens) continue;
-
-                // Loop over all bvec_bits
-                for (int bvec_i=0;bvec_i<bvec_size;++bvec_i) {
-                  if (spsens & bvec_lookup[bvec_i]) {
-                    // if dependency is found, add it to the new sparsity pattern
-                    int ind = lookup.sparsity().get_nz(bvec_i, cri);
-                    if (ind==-1) continue;
-                    jrow.push_back(bvec_i+lookup->at(ind));
-                    jcol.push_back(fri);
-                  }
-                }
-              }
-            }
-
-            // Clear the forward seeds/adjoint sensitivities, ready for next bvec sweep
-            fill(s_in.begin(), s_in.end(), 0);
-
-            // Clear the adjoint seeds/forward sensitivities, ready for next bvec sweep
-            fill(s_out.begin(), s_out.end(), 0);
+            // Save sweep, performed below
+            sweep_toggle.push_back(toggle);
+            sweep_lookup.push_back(lookup);
+            toggle.clear();
 
             // Clean lookup table
             lookup_col.clear();
@@ -1151,6 +1363,49 @@ namespace casadi {
 
       }
 
+      // Calculate sparsity for bvec_size directions at once, for each sweep
+      SpSeed seed([&](int s, bvec_t* seed_v) {
+        const std::vector<int>& t = sweep_toggle[s];
+        for (int i=0; i<t.size(); i+=3) bvec_toggle(seed_v, t[i], t[i+1], t[i+2]);
+      });
+      SpSens sens([&](int s, bvec_t* seed_v, bvec_t* sens_v,
+                      std::vector<int>& jrow, std::vector<int>& jcol) {
+        const IM& lookup = sweep_lookup[s];
+
+        // Temporary bit work vector
+        bvec_t spsens;
+
+        // Loop over the cols of coarse blocks
+        for (int cri=0;cri<coarse_col.size()-1;++cri) {
+
+          // Loop over the cols of fine blocks within the current coarse block
+          for (int fri=fine_col_lookup[coarse_col[cri]];
+               fri<fine_col_lookup[coarse_col[cri+1]];++fri) {
+            // Lump individual sensitivities together into fine block
+            bvec_or(sens_v, spsens, fine_col[fri], fine_col[fri+1]);
+
+            // Next iteration if no sparsity
+            if (!spsens) continue;
+
+            // Loop over all bvec_bits
+            for (int bvec_i=0;bvec_i<bvec_size;++bvec_i) {
+              if (spsens & bvec_lookup[bvec_i]) {
+                // if dependency is found, add it to the new sparsity pattern
+                int ind = lookup.sparsity().get_nz(bvec_i, cri);
+                if (ind==-1) continue;
+                jrow.push_back(bvec_i+lookup->at(ind));
+                jcol.push_back(fri);
+              }
+            }
+          }
+        }
+
+        // Clear the seeds and sensitivities, ready for next bvec sweep
+        fill(seed_v, seed_v+nz_seed, 0);
+        fill(sens_v, sens_v+nz_sens, 0);
+      });
+      sp_sweeps(use_fwd, iind, oind, sweep_toggle.size(), seed, sens, jrow, jcol);
+
       // Swap results if adjoint mode was used
       if (use_fwd) {
         // Construct fine sparsity pattern
@@ -1226,17 +1481,189 @@ namespace casadi {
     }
   }
 
+  void FunctionInternal::serialize(Serializer& s) const {
+    casadi_error("Serialization not supported for " + type_name() + ". "
+                 "For MX functions, consider expand()");
+  }
+
+  void FunctionInternal::serialize_jac_sparsity(Serializer& s) const {
+    for (const SparseStorage<Sparsity>* jsp : {&jac_sparsity_, &jac_sparsity_compact_}) {
+      // Blocks that have been calculated
+      vector<int> oind, iind;
+      vector<Sparsity> sp;
+      const int* colind = jsp->sparsity().colind();
+      const int* row = jsp->sparsity().row();
+      for (int i=0; i<jsp->sparsity().size2(); ++i) {
+        for (int k=colind[i]; k<colind[i+1]; ++k) {
+          if (jsp->nonzeros()[k].is_null()) continue;
+          oind.push_back(row[k]);
+          iind.push_back(i);
+          sp.push_back(jsp->nonzeros()[k]);
+        }
+      }
+      s.pack(oind);
+      s.pack(iind);
+      s.pack(sp);
+    }
+  }
+
+  void FunctionInternal::deserialize_jac_sparsity(Deserializer& s) {
+    for (bool compact : {false, true}) {
+      vector<int> oind, iind;
+      vector<Sparsity> sp;
+      s.unpack(oind);
+      s.unpack(iind);
+      s.unpack(sp);
+      casadi_assert_message(oind.size()==sp.size() && iind.size()==sp.size(),
+                            "Deserializer: Corrupt data");
+      for (int k=0; k<sp.size(); ++k) {
+        casadi_assert_message(oind[k]>=0 && oind[k]<n_out() && iind[k]>=0 && iind[k]<n_in(),
+                              "Deserializer: Corrupt data");
+        set_jac_sparsity(sp[k], iind[k], oind[k], compact);
+      }
+    }
+  }
+
+  // Identifies sparsity cache entries, followed by a format version
+  static const char sp_cache_magic[] = "CASADISP";
+  static const int sp_cache_version = 2;
+
+  // Record types of a sparsity cache entry
+  enum SpCacheRecord {SP_CACHE_JAC, SP_CACHE_PARTITION};
+
+  void FunctionInternal::sp_cache_load() {
+    // Cache key, colorings also depend on the AD weighting and the coloring method
+    string fp = structure_fingerprint();
+    if (fp.empty()) return;
+    size_t key = std::hash<std::string>()(fp);
+    hash_combine(key, std::hash<double>()(ad_weight()));
+    hash_combine(key, std::hash<std::string>()(hessian_coloring_));
+    stringstream ss;
+    ss << GlobalOptions::sparsity_cache << "/" << hex << setw(2*sizeof(size_t))
+       << setfill('0') << key << ".casadi_sp";
+    sp_cache_file_ = ss.str();
+
+    // Nothing cached yet, the entry is created with the first record
+    ifstream file(sp_cache_file_.c_str(), ios::binary);
+    if (!file.good()) return;
+
+    // Header
+    Deserializer s(file);
+    try {
+      char magic[sizeof(sp_cache_magic)-1];
+      s.read(magic, sizeof(magic));
+      casadi_assert(equal(magic, magic+sizeof(magic), sp_cache_magic));
+      int version;
+      s.unpack(version);
+      casadi_assert(version==sp_cache_version);
+      string fp_file, coloring_file;
+      double w_file;
+      s.unpack(fp_file);
+      s.unpack(w_file);
+      s.unpack(coloring_file);
+      if (fp_file!=fp || w_file!=ad_weight() || coloring_file!=hessian_coloring_) {
+        // Same key, but a different function: leave the entry alone
+        if (verbose()) log("FunctionInternal::sp_cache_load",
+                           "Key collision for " + sp_cache_file_ + ", not caching");
+        sp_cache_file_.clear();
+        return;
+      }
+    } catch(exception& e) {
+      // A stale or corrupt entry is replaced
+      if (verbose()) log("FunctionInternal::sp_cache_load",
+                         "Replacing " + sp_cache_file_ + ": " + e.what());
+      file.close();
+      sp_cache_create(fp);
+      return;
+    }
+
+    // Records, a truncated record at the end is from an interrupted write and ignored
+    try {
+      while (file.peek()!=ifstream::traits_type::eof()) {
+        int type, iind, oind;
+        s.unpack(type);
+        if (type==SP_CACHE_JAC) {
+          Sparsity sp;
+          s.unpack(iind);
+          s.unpack(oind);
+          s.unpack(sp);
+          casadi_assert(iind>=0 && iind<n_in() && oind>=0 && oind<n_out());
+          casadi_assert(sp.size1()==nnz_out(oind) && sp.size2()==nnz_in(iind));
+          set_jac_sparsity(sp, iind, oind, true);
+        } else {
+          casadi_assert(type==SP_CACHE_PARTITION);
+          vector<int> key;
+          Sparsity D1, D2;
+          s.unpack(key);
+          s.unpack(D1);
+          s.unpack(D2);
+          casadi_assert(key.size()==4);
+          iind = key[0];
+          oind = key[1];
+          casadi_assert(iind>=0 && iind<n_in() && oind>=0 && oind<n_out());
+          bool compact = key[2];
+          casadi_assert(D1.is_null() || D1.size1()==(compact ? nnz_in(iind) : numel_in(iind)));
+          casadi_assert(D2.is_null() || D2.size1()==(compact ? nnz_out(oind) : numel_out(oind)));
+          partition_[key] = make_pair(D1, D2);
+        }
+      }
+      if (verbose()) log("FunctionInternal::sp_cache_load", "Loaded " + sp_cache_file_);
+    } catch(exception& e) {
+      if (verbose()) log("FunctionInternal::sp_cache_load",
+                         "Truncated " + sp_cache_file_ + ": " + e.what());
+    }
+  }
+
+  void FunctionInternal::sp_cache_create(const std::string& fingerprint) {
+    // Write to a temporary file first, so that readers never see a partial header
+    string tmp = sp_cache_file_ + ".tmp" + CodeGenerator::to_string(random_device()());
+    {
+      ofstream file(tmp.c_str(), ios::binary);
+      if (!file.good()) {
+        casadi_warning("Cannot write sparsity cache " + tmp);
+        sp_cache_file_.clear();
+        return;
+      }
+      Serializer s(file);
+      s.write(sp_cache_magic, sizeof(sp_cache_magic)-1);
+      s.pack(sp_cache_version);
+      s.pack(fingerprint);
+      s.pack(ad_weight());
+      s.pack(hessian_coloring_);
+    }
+    if (std::rename(tmp.c_str(), sp_cache_file_.c_str())!=0) {
+      std::remove(tmp.c_str());
+      sp_cache_file_.clear();
+    }
+  }
+
+  void FunctionInternal::sp_cache_append(const std::string& record) {
+    if (sp_cache_file_.empty()) return;
+
+    // Start a new entry
+    if (!ifstream(sp_cache_file_.c_str()).good()) {
+      sp_cache_create(structure_fingerprint());
+      if (sp_cache_file_.empty()) return;
+    }
+
+    // A single write, so that concurrent writers do not interleave
+    ofstream file(sp_cache_file_.c_str(), ios::binary | ios::app);
+    if (file.good()) file.write(record.data(), record.size());
+  }
+
   Sparsity& FunctionInternal::sparsity_jac(int iind, int oind, bool compact, bool symmetric) {
     // Get an owning reference to the block
     Sparsity jsp = compact ? jac_sparsity_compact_.elem(oind, iind)
         : jac_sparsity_.elem(oind, iind);
 
     // Generate, if null
+    bool generated = false;
     if (jsp.is_null()) {
       if (compact) {
 
         // Use internal routine to determine sparsity
         jsp = getJacSparsity(iind, oind, symmetric);
+        generated = true;
 
       } else {
 
@@ -1279,13 +1706,54 @@ namespace casadi {
     Sparsity& jsp_ref = compact ? jac_sparsity_compact_.elem(oind, iind) :
         jac_sparsity_.elem(oind, iind);
     jsp_ref = jsp;
+
+    // Update the persistent cache
+    if (generated && !sp_cache_file_.empty()) {
+      stringstream record;
+      Serializer s(record);
+      s.pack(static_cast<int>(SP_CACHE_JAC));
+      s.pack(iind);
+      s.pack(oind);
+      s.pack(jsp_ref);
+      sp_cache_append(record.str());
+    }
     return jsp_ref;
   }
 
+  /// Bidirectional partition of J: rows[0..k) in adjoint mode, the other entries in forward mode
+  static void bidirectional_partition(const Sparsity& J, const vector<int>& rows, int k,
+                                      Sparsity& Dfwd, Sparsity& Dadj) {
+    vector<bool> is_adj(J.size1(), false);
+    for (int i=0; i<k; ++i) is_adj[rows[i]] = true;
+    vector<int> rr_fwd, rr_adj(rows.begin(), rows.begin()+k), mapping;
+    for (int i=0; i<J.size1(); ++i) if (!is_adj[i]) rr_fwd.push_back(i);
+
+    // Columns not sharing any of the remaining rows share a forward direction
+    Sparsity J_fwd = J.sub(rr_fwd, range(J.size2()), mapping);
+    Dfwd = J_fwd.uni_coloring(J_fwd.T());
+
+    // Dense rows not sharing any column share an adjoint direction
+    Sparsity J_adj = J.sub(rr_adj, range(J.size2()), mapping).T();
+    Sparsity D = J_adj.uni_coloring(J_adj.T());
+    vector<int> adj_row = D.get_row();
+    for (auto&& r : adj_row) r = rr_adj[r];
+    Dadj = Sparsity::triplet(J.size1(), D.size2(), adj_row, D.get_col());
+  }
+
   void FunctionInternal::getPartition(int iind, int oind, Sparsity& D1, Sparsity& D2,
                                       bool compact, bool symmetric) {
     log("FunctionInternal::getPartition begin");
 
+    // Cached colorings
+    vector<int> key = {iind, oind, compact, symmetric};
+    auto cached = partition_.find(key);
+    if (cached!=partition_.end()) {
+      D1 = cached->second.first;
+      D2 = cached->second.second;
+      log("FunctionInternal::getPartition cached");
+      return;
+    }
+
     // Sparsity pattern with transpose
     Sparsity &AT = sparsity_jac(iind, oind, compact, symmetric);
     Sparsity A = symmetric ? AT : AT.T();
@@ -1294,11 +1762,19 @@ namespace casadi {
     if (symmetric) {
       casadi_assert(get_n_forward()>0);
 
-      // Star coloring if symmetric
-      log("FunctionInternal::getPartition star_coloring");
-      D1 = A.star_coloring();
-      casadi_msg("Star coloring completed: " << D1.size2() << " directional derivatives needed ("
-                 << A.size1() << " without coloring).");
+      if (hessian_coloring_=="acyclic") {
+        // Acyclic coloring, entries recovered by substitution
+        log("FunctionInternal::getPartition acyclic_coloring");
+        D1 = A.acyclic_coloring();
+        casadi_msg("Acyclic coloring completed: " << D1.size2()
+                   << " directional derivatives needed (" << A.size1() << " without coloring).");
+      } else {
+        // Star coloring if symmetric
+        log("FunctionInternal::getPartition star_coloring");
+        D1 = A.star_coloring();
+        casadi_msg("Star coloring completed: " << D1.size2()
+                   << " directional derivatives needed (" << A.size1() << " without coloring).");
+      }
 
     } else {
       casadi_assert(get_n_forward()>0 || get_n_reverse()>0);
@@ -1359,6 +1835,53 @@ namespace casadi {
         }
       }
 
+      // Bidirectional partitions: dense rows in adjoint mode or dense columns in forward mode
+      if (test_ad_fwd && test_ad_adj) {
+        for (bool tr : {false, true}) {
+          const Sparsity& J = tr ? A : AT;
+
+          // Rows sorted by decreasing number of nonzeros
+          vector<int> count(J.size1(), 0);
+          const int* J_row = J.row();
+          for (int k=0; k<J.nnz(); ++k) count[J_row[k]]++;
+          vector<int> rows = range(J.size1());
+          stable_sort(rows.begin(), rows.end(),
+                      [&](int i, int j) { return count[i]>count[j];});
+
+          // Try the dense rows, where the row counts drop
+          double dense = 2.0*J.nnz()/max(J.size1(), 1);
+          int n_tried = 0;
+          for (int k=1; k<=J.size1()/2 && n_tried<8; ++k) {
+            if (count[rows[k-1]]<=dense) break;
+            if (count[rows[k-1]]==count[rows[k]]) continue;
+            n_tried++;
+            Sparsity Dfwd, Dadj;
+            bidirectional_partition(J, rows, k, Dfwd, Dadj);
+            int nfwd = tr ? Dadj.size2() : Dfwd.size2();
+            int nadj = tr ? Dfwd.size2() : Dadj.size2();
+            if (w*nfwd + (1-w)*nadj < best_coloring) {
+              D1 = tr ? Dadj : Dfwd;
+              D2 = tr ? Dfwd : Dadj;
+              best_coloring = w*nfwd + (1-w)*nadj;
+              if (verbose()) userOut() << "Bidirectional coloring completed: " << nfwd
+                                 << " forward and " << nadj << " adjoint directions needed."
+                                 << endl;
+            }
+          }
+        }
+      }
+    }
+
+    // Update the persistent cache
+    if (!sp_cache_file_.empty()) {
+      partition_[key] = make_pair(D1, D2);
+      stringstream record;
+      Serializer s(record);
+      s.pack(static_cast<int>(SP_CACHE_PARTITION));
+      s.pack(key);
+      s.pack(D1);
+      s.pack(D2);
+      sp_cache_append(record.str());
     }
     log("FunctionInternal::getPartition end");
   }
@@ -2155,6 +2678,15 @@ namespace casadi {
     }
   }
 
+  void FunctionInternal::sp_fwd_wide(const bvec_t** arg, bvec_t** res, int* iw, bvec_t* w,
+                                     int nw) {
+    casadi_error("'sp_fwd_wide' not defined for " + type_name());
+  }
+
+  void FunctionInternal::sp_rev_wide(bvec_t** arg, bvec_t** res, int* iw, bvec_t* w, int nw) {
+    casadi_error("'sp_rev_wide' not defined for " + type_name());
+  }
+
   void FunctionInternal::sz_work(size_t& sz_arg, size_t& sz_res,
                                  size_t& sz_iw, size_t& sz_w) const {
     sz_arg = this->sz_arg();
@@ -2725,10 +3257,12 @@ namespace casadi {
   }
 
   void FunctionInternal::clear_memory() {
+    std::lock_guard<std::mutex> lock(mem_mtx_);
     for (auto&& i : mem_) {
       if (i!=0) free_memory(i);
     }
     mem_.clear();
+    unused_ = std::stack<int>();
   }
 
   size_t FunctionInternal::get_n_in() {
@@ -2778,28 +3312,50 @@ namespace casadi {
   }
 
   void* FunctionInternal::memory(int ind) const {
+    std::lock_guard<std::mutex> lock(mem_mtx_);
     return mem_.at(ind);
   }
 
-  int FunctionInternal::checkout() const {
-    if (unused_.empty()) {
-      // Allocate a new memory object
+  int FunctionInternal::checkout(bool nested) const {
+    int ind;
+    {
+      std::lock_guard<std::mutex> lock(mem_mtx_);
+      bool skip = nested && !unused_.empty() && unused_.top()==0;
+      if (skip) unused_.pop();
+      if (!unused_.empty()) {
+        // Use an unused memory object
+        ind = unused_.top();
+        unused_.pop();
+        if (skip) unused_.push(0);
+        return ind;
+      }
+      if (skip) unused_.push(0);
+      // Reserve a slot for a new memory object
       int n_mem = this->n_mem();
       casadi_assert_message(n_mem==0 || mem_.size()<n_mem,
                             "Too many memory objects");
-      void* m = alloc_memory();
-      mem_.push_back(m);
-      if (m) init_memory(m);
-      return mem_.size()-1;
-    } else {
-      // Use an unused memory object
-      int m = unused_.top();
-      unused_.pop();
-      return m;
+      ind = mem_.size();
+      mem_.push_back(0);
+    }
+
+    // Allocate and initialize outside the lock, the slot is not visible to other threads
+    void* m = alloc_memory();
+    if (m) {
+      try {
+        init_memory(m);
+      } catch(...) {
+        // Slot remains empty
+        free_memory(m);
+        throw;
+      }
     }
+    std::lock_guard<std::mutex> lock(mem_mtx_);
+    mem_[ind] = m;
+    return ind;
   }
 
   void FunctionInternal::release(int mem) const {
+    std::lock_guard<std::mutex> lock(mem_mtx_);
     unused_.push(mem);
   }
 
@@ -30,6 +30,8 @@
 #include "../weak_ref.hpp"
 #include <set>
 #include <stack>
+#include <mutex>
+#include <functional>
 #include "code_generator.hpp"
 #include "importer.hpp"
 #include "../sparse_storage.hpp"
@@ -44,6 +46,11 @@
 /// \cond INTERNAL
 
 namespace casadi {
+  // Forward declaration
+  struct FunctionMemo;
+  class Serializer;
+  class Deserializer;
+
   template<typename T>
   std::vector<std::pair<std::string, T>> zip(const std::vector<std::string>& id,
                                              const std::vector<T>& mat) {
@@ -145,6 +152,13 @@ namespace casadi {
     virtual bool has_sprev() const { return false;}
     ///@}
 
+    /** \brief Can seeds be propagated from several threads concurrently?
+     *
+     * Only the first propagation may initialize data members, e.g. cached sparsity
+     * patterns, the following ones must only read shared data.
+     */
+    virtual bool has_parallel_sp() const { return false;}
+
     ///@{
     /** \brief  Evaluate numerically */
     void _eval(const double** arg, double** res, int* iw, double* w, int mem);
@@ -612,9 +626,58 @@ namespace casadi {
     */
     Sparsity getJacSparsityHierarchicalSymm(int iind, int oind);
 
+    ///@{
+    /** \brief Sparsity propagation sweeps, cf. sp_sweeps */
+    typedef std::function<void(int s, bvec_t* seed)> SpSeed;
+    typedef std::function<void(int s, bvec_t* seed, bvec_t* sens,
+                               std::vector<int>& jrow, std::vector<int>& jcol)> SpSens;
+    ///@}
+
+    /** \brief Perform independent sparsity propagation sweeps, in parallel if possible
+     *
+     * For sweep s = 0, ..., nsweep-1, seed(s, seed) sets the seeds for input \a iind
+     * (forward mode) or output \a oind (reverse mode), the seeds are propagated and
+     * sens(s, seed, sens, jrow, jcol) records the pattern entries found. sens must also
+     * clear the seeds and sensitivities for the next sweep. The entries of all sweeps are
+     * appended to \a jrow and \a jcol in sweep order. The sweeps are distributed over
+     * up to GlobalOptions::sparsity_threads workers of the shared thread pool if
+     * has_parallel_sp() is true and the function is large enough to benefit. If
+     * has_sp_wide() is true, GlobalOptions::sparsity_width sweeps are propagated together.
+     */
+    void sp_sweeps(bool fwd, int iind, int oind, int nsweep, const SpSeed& seed,
+                   const SpSens& sens, std::vector<int>& jrow, std::vector<int>& jcol);
+
     /// Generate the sparsity of a Jacobian block
     void set_jac_sparsity(const Sparsity& sp, int iind, int oind, bool compact);
 
+    /** \brief Serialize the class specific data, cf. Function::save */
+    virtual void serialize(Serializer& s) const;
+
+    ///@{
+    /** \brief Serialize the Jacobian sparsity patterns calculated so far */
+    void serialize_jac_sparsity(Serializer& s) const;
+    void deserialize_jac_sparsity(Deserializer& s);
+    ///@}
+
+    /** \brief Binary description of the algorithm and the input and output sparsity patterns
+     * Functions with the same fingerprint must have the same Jacobian sparsity patterns.
+     * Empty means that the structure cannot be described.
+     */
+    virtual std::string structure_fingerprint() const { return std::string();}
+
+    ///@{
+    /** \brief Persistent cache of Jacobian sparsity patterns and colorings,
+     * cf. GlobalOptions::sparsity_cache
+     *
+     * An entry starts with the fingerprint of the function, which is compared on loading,
+     * followed by one record for each compact Jacobian block or coloring, appended as
+     * soon as it has been calculated.
+     */
+    void sp_cache_load();
+    void sp_cache_create(const std::string& fingerprint);
+    void sp_cache_append(const std::string& record);
+    ///@}
+
     /// Get, if necessary generate, the sparsity of a Jacobian block
     Sparsity& sparsity_jac(int iind, int oind, bool compact, bool symmetric);
 
@@ -694,6 +757,19 @@ namespace casadi {
     /** \brief  Propagate sparsity backwards */
     virtual void sp_rev(bvec_t** arg, bvec_t** res, int* iw, bvec_t* w, int mem);
 
+    /** \brief Can several sets of bvec_size directions be propagated in a single pass? */
+    virtual bool has_sp_wide() const { return false;}
+
+    ///@{
+    /** \brief Propagate \a nw sets of directions at once, cf. has_sp_wide
+     *
+     * Each nonzero of the inputs, outputs and the work vector holds \a nw consecutive
+     * words, one for each set of directions. Requires sz_w()*nw entries in \a w.
+     */
+    virtual void sp_fwd_wide(const bvec_t** arg, bvec_t** res, int* iw, bvec_t* w, int nw);
+    virtual void sp_rev_wide(bvec_t** arg, bvec_t** res, int* iw, bvec_t* w, int nw);
+    ///@}
+
     /** \brief Get number of temporary variables needed */
     void sz_work(size_t& sz_arg, size_t& sz_res, size_t& sz_iw, size_t& sz_w) const;
 
@@ -745,7 +821,7 @@ namespace casadi {
     ///@{
     /// Get all statistics
     virtual Dict get_stats(void* mem) const { return Dict();}
-    virtual Dict _get_stats(int mem) const { return get_stats(memory(mem));}
+    virtual Dict _get_stats(int mem) const;
     ///@}
 
     ///@{
@@ -782,10 +858,17 @@ namespace casadi {
     virtual bool adjViaJac(int nadj);
     ///@}
 
-    /// Checkout a memory object
-    int checkout() const;
+    /** \brief Checkout a memory object
+
+        Hands out an unused memory object, allocating and initializing a new one
+        if all existing objects are in use. Thread-safe, so that each thread
+        evaluating the function concurrently can obtain its own memory object.
+        Memory objects for calls nested in other functions (\a nested) are never
+        memory object 0, which is left for direct calls and is the one reported by stats().
+    */
+    int checkout(bool nested=false) const;
 
-    /// Release a memory object
+    /// Release a memory object (thread-safe)
     void release(int mem) const;
 
     /// Input and output sparsity
@@ -819,6 +902,12 @@ namespace casadi {
     /// Cache for sparsities of the Jacobian blocks
     SparseStorage<Sparsity> jac_sparsity_, jac_sparsity_compact_;
 
+    /// Cache for graph colorings, indexed by (iind, oind, compact, symmetric)
+    std::map<std::vector<int>, std::pair<Sparsity, Sparsity> > partition_;
+
+    /// File for the persistent sparsity cache, empty if disabled
+    std::string sp_cache_file_;
+
     /// Cache for Jacobians
     SparseStorage<WeakRef> jac_, jac_compact_;
 
@@ -842,6 +931,9 @@ namespace casadi {
     /// Weighting factor for derivative calculation and sparsity pattern calculation
     double ad_weight_, ad_weight_sp_;
 
+    /// Graph coloring for symmetric Jacobians, "star" or "acyclic"
+    std::string hessian_coloring_;
+
     /// Maximum number of sensitivity directions
     int max_num_dir_;
 
@@ -854,6 +946,18 @@ namespace casadi {
     // Print timing statistics
     bool print_time_;
 
+    /// Maximum number of cached evaluations, 0 if memoization is disabled
+    int memoize_;
+
+    /// Cache of numerical evaluations (null if memoization is disabled)
+    FunctionMemo* memo_;
+
+    /// Look up the outputs for the given inputs in the cache, false if not found
+    bool memo_lookup(const double** arg, double** res) const;
+
+    /// Add the result of an evaluation to the cache
+    void memo_store(const double** arg, double** res) const;
+
     /** \brief Get type name */
     virtual std::string type_name() const;
 
@@ -882,6 +986,9 @@ namespace casadi {
     /// Unused memory objects
     mutable std::stack<int> unused_;
 
+    /// Protects mem_ and unused_
+    mutable std::mutex mem_mtx_;
+
     /** \brief Memory that is persistent during a call (but not between calls) */
     size_t sz_arg_per_, sz_res_per_, sz_iw_per_, sz_w_per_;
 
@@ -1001,8 +1108,15 @@ namespace casadi {
     std::vector<D*> resp(sz_res());
     for (int i=0; i<n_out; ++i) resp[i]=get_ptr(res[i]);
 
-    // Call memory-less
-    _eval(get_ptr(argp), get_ptr(resp), get_ptr(iw_tmp), get_ptr(w_tmp), 0);
+    // Evaluate with a memory object of our own, allowing concurrent calls
+    int mem = checkout();
+    try {
+      _eval(get_ptr(argp), get_ptr(resp), get_ptr(iw_tmp), get_ptr(w_tmp), mem);
+    } catch(...) {
+      release(mem);
+      throw;
+    }
+    release(mem);
   }
 
   template<typename M>
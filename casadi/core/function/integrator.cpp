@@ -1078,6 +1078,17 @@ namespace casadi {
     m->rx_prev.resize(nrx_);
     m->RZ_prev.resize(nRZ_);
     m->rq_prev.resize(nrq_);
+
+    // Separate memory objects for the discrete time dynamics, which may contain rootfinders
+    m->F_mem = getExplicit()->checkout(true);
+    if (!getExplicitB().is_null()) m->G_mem = getExplicitB()->checkout(true);
+  }
+
+  void FixedStepIntegrator::free_memory(void *mem) const {
+    auto m = static_cast<FixedStepMemory*>(mem);
+    if (m->F_mem>=0) getExplicit().release(m->F_mem);
+    if (m->G_mem>=0) getExplicitB().release(m->G_mem);
+    delete m;
   }
 
   void FixedStepIntegrator::advance(IntegratorMemory* mem, double t,
@@ -1113,7 +1124,7 @@ namespace casadi {
       casadi_copy(get_ptr(m->q), nq_, get_ptr(m->q_prev));
 
       // Take step
-      F(m->arg, m->res, m->iw, m->w, 0);
+      F(m->arg, m->res, m->iw, m->w, m->F_mem);
       casadi_axpy(nq_, 1., get_ptr(m->q_prev), get_ptr(m->q));
 
       // Tape
@@ -1173,7 +1184,7 @@ namespace casadi {
       // Take step
       m->arg[RDAE_X] = get_ptr(m->x_tape.at(m->k));
       m->arg[RDAE_Z] = get_ptr(m->Z_tape.at(m->k));
-      G(m->arg, m->res, m->iw, m->w, 0);
+      G(m->arg, m->res, m->iw, m->w, m->G_mem);
       casadi_axpy(nrq_, 1., get_ptr(m->rq_prev), get_ptr(m->rq));
     }
 
@@ -1243,6 +1254,8 @@ namespace casadi {
   }
 
   ImplicitFixedStepIntegrator::~ImplicitFixedStepIntegrator() {
+    // Before the rootfinders are destroyed
+    clear_memory();
   }
 
   Options ImplicitFixedStepIntegrator::options_
@@ -237,6 +237,11 @@ namespace casadi {
 
     // Tape
     std::vector<std::vector<double> > x_tape, Z_tape;
+
+    // Memory objects of the discrete time dynamics
+    int F_mem, G_mem;
+
+    FixedStepMemory() : F_mem(-1), G_mem(-1) {}
   };
 
   class CASADI_EXPORT FixedStepIntegrator : public Integrator {
@@ -261,7 +266,7 @@ namespace casadi {
     virtual void* alloc_memory() const { return new FixedStepMemory();}
 
     /** \brief Free memory block */
-    virtual void free_memory(void *mem) const { delete static_cast<FixedStepMemory*>(mem);}
+    virtual void free_memory(void *mem) const;
 
     /** \brief Initalize memory block */
     virtual void init_memory(void* mem) const;
@@ -43,10 +43,36 @@ namespace casadi {
   LinsolInternal::~LinsolInternal() {
   }
 
+  Options LinsolInternal::options_
+  = {{&FunctionInternal::options_},
+     {{"refactor",
+       {OT_BOOL,
+        "Refactorize with the pivot sequence of the previous factorization if the "
+        "sparsity pattern is unchanged, falling back to a full factorization if "
+        "the stability test fails. Only for solvers that support it [true]"}},
+      {"batch_dense_max",
+       {OT_INT,
+        "Batches of systems up to this size are solved with a dense factorization "
+        "vectorized across the batch, 0 to disable [32]"}}
+     }
+  };
+
   void LinsolInternal::init(const Dict& opts) {
     // Call the base class initializer
     FunctionInternal::init(opts);
 
+    // Default options
+    refactor_ = true;
+    batch_dense_max_ = 32;
+
+    // Read options
+    for (auto&& op : opts) {
+      if (op.first=="refactor") {
+        refactor_ = op.second;
+      } else if (op.first=="batch_dense_max") {
+        batch_dense_max_ = op.second;
+      }
+    }
   }
 
   void LinsolInternal::init_memory(void* mem) const {
@@ -62,6 +88,193 @@ namespace casadi {
     casadi_error("'solve' not defined for " + type_name());
   }
 
+  /// Dense LU factorizations with partial pivoting of batch_size systems, lane-interleaved
+  static void batch_lu(double* a, int* p, int n) {
+    const int L = LinsolInternal::batch_size;
+    for (int k=0; k<n; ++k) {
+      // Pivot row for each lane
+      for (int l=0; l<L; ++l) {
+        int r = k;
+        double amax = fabs(a[(k+k*n)*L+l]);
+        for (int i=k+1; i<n; ++i) {
+          if (fabs(a[(i+k*n)*L+l])>amax) {
+            amax = fabs(a[(i+k*n)*L+l]);
+            r = i;
+          }
+        }
+        casadi_assert_message(amax>0, "Linsol: Singular matrix in batch");
+        p[k*L+l] = r;
+        if (r!=k) {
+          for (int j=0; j<n; ++j) std::swap(a[(k+j*n)*L+l], a[(r+j*n)*L+l]);
+        }
+      }
+
+      // Scale the pivot column
+      double* akk = a + (k+k*n)*L;
+      for (int i=k+1; i<n; ++i) {
+        double* aik = a + (i+k*n)*L;
+        for (int l=0; l<L; ++l) aik[l] /= akk[l];
+      }
+
+      // Update the trailing block
+      for (int j=k+1; j<n; ++j) {
+        const double* akj = a + (k+j*n)*L;
+        for (int i=k+1; i<n; ++i) {
+          const double* aik = a + (i+k*n)*L;
+          double* aij = a + (i+j*n)*L;
+          for (int l=0; l<L; ++l) aij[l] -= aik[l]*akj[l];
+        }
+      }
+    }
+  }
+
+  /// Dense Cholesky factorizations of batch_size systems, lane-interleaved
+  static void batch_chol(double* a, int n) {
+    const int L = LinsolInternal::batch_size;
+    for (int k=0; k<n; ++k) {
+      double* akk = a + (k+k*n)*L;
+      for (int l=0; l<L; ++l) {
+        casadi_assert_message(akk[l]>0, "Linsol: Matrix in batch not positive definite");
+        akk[l] = sqrt(akk[l]);
+      }
+      for (int i=k+1; i<n; ++i) {
+        double* aik = a + (i+k*n)*L;
+        for (int l=0; l<L; ++l) aik[l] /= akk[l];
+      }
+      for (int j=k+1; j<n; ++j) {
+        const double* ajk = a + (j+k*n)*L;
+        for (int i=j; i<n; ++i) {
+          const double* aik = a + (i+k*n)*L;
+          double* aij = a + (i+j*n)*L;
+          for (int l=0; l<L; ++l) aij[l] -= aik[l]*ajk[l];
+        }
+      }
+    }
+  }
+
+  /// Solve with batched dense LU or Cholesky factors, lane-interleaved right-hand side
+  static void batch_solve(const double* a, const int* p, double* b, int n, bool tr) {
+    const int L = LinsolInternal::batch_size;
+    if (p==0) {
+      // Cholesky: forward substitution with L, then backward substitution with L'
+      for (int k=0; k<n; ++k) {
+        double* bk = b + k*L;
+        for (int l=0; l<L; ++l) bk[l] /= a[(k+k*n)*L+l];
+        for (int i=k+1; i<n; ++i) {
+          const double* aik = a + (i+k*n)*L;
+          double* bi = b + i*L;
+          for (int l=0; l<L; ++l) bi[l] -= aik[l]*bk[l];
+        }
+      }
+      for (int k=n-1; k>=0; --k) {
+        double* bk = b + k*L;
+        for (int i=k+1; i<n; ++i) {
+          const double* aik = a + (i+k*n)*L;
+          const double* bi = b + i*L;
+          for (int l=0; l<L; ++l) bk[l] -= aik[l]*bi[l];
+        }
+        for (int l=0; l<L; ++l) bk[l] /= a[(k+k*n)*L+l];
+      }
+    } else if (!tr) {
+      // Row interchanges, then unit lower and upper triangular solves
+      for (int k=0; k<n; ++k) {
+        for (int l=0; l<L; ++l) std::swap(b[k*L+l], b[p[k*L+l]*L+l]);
+      }
+      for (int k=0; k<n; ++k) {
+        const double* bk = b + k*L;
+        for (int i=k+1; i<n; ++i) {
+          const double* aik = a + (i+k*n)*L;
+          double* bi = b + i*L;
+          for (int l=0; l<L; ++l) bi[l] -= aik[l]*bk[l];
+        }
+      }
+      for (int k=n-1; k>=0; --k) {
+        double* bk = b + k*L;
+        for (int l=0; l<L; ++l) bk[l] /= a[(k+k*n)*L+l];
+        for (int i=0; i<k; ++i) {
+          const double* aik = a + (i+k*n)*L;
+          double* bi = b + i*L;
+          for (int l=0; l<L; ++l) bi[l] -= aik[l]*bk[l];
+        }
+      }
+    } else {
+      // Transposed: solve with U', then with L', then undo the row interchanges
+      for (int k=0; k<n; ++k) {
+        double* bk = b + k*L;
+        for (int i=0; i<k; ++i) {
+          const double* aik = a + (i+k*n)*L;
+          const double* bi = b + i*L;
+          for (int l=0; l<L; ++l) bk[l] -= aik[l]*bi[l];
+        }
+        for (int l=0; l<L; ++l) bk[l] /= a[(k+k*n)*L+l];
+      }
+      for (int k=n-1; k>=0; --k) {
+        double* bk = b + k*L;
+        for (int i=k+1; i<n; ++i) {
+          const double* aik = a + (i+k*n)*L;
+          const double* bi = b + i*L;
+          for (int l=0; l<L; ++l) bk[l] -= aik[l]*bi[l];
+        }
+      }
+      for (int k=n-1; k>=0; --k) {
+        for (int l=0; l<L; ++l) std::swap(b[k*L+l], b[p[k*L+l]*L+l]);
+      }
+    }
+  }
+
+  bool LinsolInternal::solve_batch(void* mem, const double* A, int stride_A, double* x,
+                                   int stride_x, int nrhs, bool tr, int n) const {
+    auto m = static_cast<LinsolMemory*>(mem);
+    int nc = m->ncol();
+    if (n<2 || nc>batch_dense_max_) return false;
+    const int L = batch_size;
+    const int *colind = m->colind(), *row = m->row();
+    bool chol = batch_cholesky();
+
+    // Lane-interleaved dense matrices, pivots and right-hand side
+    std::vector<double> a(nc*nc*L), b(nc*L);
+    std::vector<int> p(chol ? 0 : nc*L);
+    for (int offset=0; offset<n; offset+=L) {
+      // Number of active lanes, the remaining lanes hold identity matrices
+      int nl = std::min(L, n-offset);
+
+      // Scatter the nonzeros
+      std::fill(a.begin(), a.end(), 0);
+      for (int c=0; c<nc; ++c) {
+        for (int el=colind[c]; el<colind[c+1]; ++el) {
+          // Upper triangular entries are mirrored for Cholesky
+          int r = row[el];
+          double* ar = get_ptr(a) + (chol && r<c ? c+r*nc : r+c*nc)*L;
+          const double* Ak = A + offset*stride_A + el;
+          for (int l=0; l<nl; ++l) ar[l] = Ak[l*stride_A];
+        }
+      }
+      for (int c=0; c<nc; ++c) {
+        for (int l=nl; l<L; ++l) a[(c+c*nc)*L+l] = 1;
+      }
+
+      // Factorize
+      if (chol) {
+        batch_chol(get_ptr(a), nc);
+      } else {
+        batch_lu(get_ptr(a), get_ptr(p), nc);
+      }
+
+      // Solve for each right-hand side
+      for (int r=0; r<nrhs; ++r) {
+        double* xr = x + offset*stride_x + r*nc;
+        for (int i=0; i<nc; ++i) {
+          for (int l=0; l<nl; ++l) b[i*L+l] = xr[l*stride_x + i];
+        }
+        batch_solve(get_ptr(a), chol ? 0 : get_ptr(p), get_ptr(b), nc, tr);
+        for (int i=0; i<nc; ++i) {
+          for (int l=0; l<nl; ++l) xr[l*stride_x + i] = b[i*L+l];
+        }
+      }
+    }
+    return true;
+  }
+
   void LinsolInternal::solve_cholesky(void* mem, double* x, int nrhs, bool tr) const {
     casadi_error("'solve_cholesky' not defined for " + type_name());
   }
@@ -112,6 +325,14 @@ namespace casadi {
     casadi_error("'rank' not defined for " + type_name());
   }
 
+  Dict LinsolInternal::get_stats(void* mem) const {
+    auto m = static_cast<LinsolMemory*>(mem);
+    Dict stats;
+    stats["n_factorize"] = m->n_factorize;
+    stats["n_refactorize"] = m->n_refactorize;
+    return stats;
+  }
+
   std::map<std::string, LinsolInternal::Plugin> LinsolInternal::solvers_;
 
   const std::string LinsolInternal::infix_ = "linsol";
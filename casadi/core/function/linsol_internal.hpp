@@ -41,6 +41,9 @@ namespace casadi {
     // Current state of factorization
     bool is_pivoted, is_factorized;
 
+    // Number of full factorizations and of refactorizations
+    int n_factorize, n_refactorize;
+
     /// Get sparsity pattern
     int nrow() const { return sparsity[0];}
     int ncol() const { return sparsity[1];}
@@ -49,7 +52,8 @@ namespace casadi {
     int nnz() const { return colind()[ncol()];}
 
     // Constructor
-    LinsolMemory() : is_pivoted(false), is_factorized(false) {}
+    LinsolMemory() : is_pivoted(false), is_factorized(false),
+      n_factorize(0), n_refactorize(0) {}
   };
 
   /** Internal class
@@ -70,6 +74,12 @@ namespace casadi {
     virtual size_t get_n_out() { return 0;}
     ///@}
 
+    ///@{
+    /** \brief Options */
+    static Options options_;
+    virtual const Options& get_options() const { return options_;}
+    ///@}
+
     /// Initialize
     virtual void init(const Dict& opts);
 
@@ -98,9 +108,31 @@ namespace casadi {
     /// Factorize the linear system
     virtual void factorize(void* mem, const double* A) const;
 
+    /** \brief Refactorize, reusing the pivot sequence of the previous factorization
+
+        Returns false if not supported or if the pivots fail the stability test,
+        in which case a full factorization is performed instead
+    */
+    virtual bool refactorize(void* mem, const double* A) const { return false;}
+
     // Solve numerically
     virtual void solve(void* mem, double* x, int nrhs, bool tr) const;
 
+    /** \brief Factorize and solve \a n systems with the same sparsity pattern
+
+        The nonzeros of system k are found at A + k*stride_A and its right-hand sides
+        at x + k*stride_x. Returns false if not supported, in which case the systems
+        are factorized and solved one at a time.
+    */
+    virtual bool solve_batch(void* mem, const double* A, int stride_A, double* x,
+                             int stride_x, int nrhs, bool tr, int n) const;
+
+    /// Use a Cholesky instead of an LU factorization for batched dense systems
+    virtual bool batch_cholesky() const { return false;}
+
+    /// Number of systems factorized simultaneously by the batched dense solver
+    static const int batch_size = 8;
+
     /// Sparsity pattern of the cholesky factors
     virtual Sparsity linsol_cholesky_sparsity(void* mem, bool tr) const;
 
@@ -113,6 +145,9 @@ namespace casadi {
     /// Matrix rank
     virtual int rank(void* mem) const;
 
+    /// Get all statistics
+    virtual Dict get_stats(void* mem) const;
+
     // Creator function for internal class
     typedef LinsolInternal* (*Creator)(const std::string& name);
 
@@ -127,6 +162,12 @@ namespace casadi {
 
     // Get name of the plugin
     virtual const char* plugin_name() const = 0;
+
+    /// Reuse the pivot sequence when refactorizing
+    bool refactor_;
+
+    /// Largest system solved with the batched dense solver
+    int batch_dense_max_;
   };
 
 
@@ -24,6 +24,19 @@
 
 
 #include "map.hpp"
+#include "sx_function.hpp"
+#include "mx_function.hpp"
+#include "../thread_pool.hpp"
+#include <cstring>
+#include <atomic>
+
+#ifndef _WIN32
+#define CASADI_HAS_MAP_PROCESS
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#endif // _WIN32
 
 using namespace std;
 
@@ -38,6 +51,10 @@ namespace casadi {
       ret.assignNode(new Map(name, f, n));
     } else if (parallelization== "openmp") {
       ret.assignNode(new MapOmp(name, f, n));
+    } else if (parallelization== "thread") {
+      ret.assignNode(new MapThread(name, f, n));
+    } else if (parallelization== "process") {
+      ret.assignNode(new MapProcess(name, f, n));
     } else {
       casadi_error("Unknown parallelization: " + parallelization);
     }
@@ -48,6 +65,7 @@ namespace casadi {
 
   Map::Map(const std::string& name, const Function& f, int n)
     : FunctionInternal(name), f_(f), n_(n) {
+    batch_ = batch_mx_ = false;
   }
 
   Map::~Map() {
@@ -62,6 +80,16 @@ namespace casadi {
     alloc_res(f_.sz_res());
     alloc_w(f_.sz_w());
     alloc_iw(f_.sz_iw());
+
+    // Serial evaluation of an (interpreted) SXFunction can be batched
+    batch_ = parallelization()=="serial" && f_.is_a("sxfunction") && f_->eval_==0
+      && f_.get<SXFunction>()->native_jit_==0;
+    if (batch_) alloc_w(f_.sz_w() * SXFunction::batch_size);
+
+    // Serial evaluation of an MXFunction with e.g. linear solves, which are batched
+    batch_mx_ = parallelization()=="serial" && f_.is_a("mxfunction") && f_->eval_==0
+      && f_.get<MXFunction>()->has_eval_batch();
+    if (batch_mx_) alloc_w(f_.sz_w() * MXFunction::batch_size);
   }
 
   template<typename T>
@@ -71,15 +99,23 @@ namespace casadi {
     copy_n(arg, n_in, arg1);
     T** res1 = res+n_out;
     copy_n(res, n_out, res1);
-    for (int i=0; i<n_; ++i) {
-      f_(arg1, res1, iw, w, 0);
-      for (int j=0; j<n_in; ++j) {
-        if (arg1[j]) arg1[j] += f_.nnz_in(j);
-      }
-      for (int j=0; j<n_out; ++j) {
-        if (res1[j]) res1[j] += f_.nnz_out(j);
+    // Memory object of our own, the map may be evaluated from several threads
+    int mem = f_.checkout();
+    try {
+      for (int i=0; i<n_; ++i) {
+        f_(arg1, res1, iw, w, mem);
+        for (int j=0; j<n_in; ++j) {
+          if (arg1[j]) arg1[j] += f_.nnz_in(j);
+        }
+        for (int j=0; j<n_out; ++j) {
+          if (res1[j]) res1[j] += f_.nnz_out(j);
+        }
       }
+    } catch (...) {
+      f_.release(mem);
+      throw;
     }
+    f_.release(mem);
   }
 
   void Map::eval_sx(const SXElem** arg, SXElem** res, int* iw, SXElem* w, int mem) {
@@ -91,18 +127,59 @@ namespace casadi {
   }
 
   void Map::sp_rev(bvec_t** arg, bvec_t** res, int* iw, bvec_t* w, int mem) {
+    int n_in = this->n_in(), n_out = this->n_out();
+    bvec_t** arg1 = arg+n_in;
+    copy_n(arg, n_in, arg1);
+    bvec_t** res1 = res+n_out;
+    copy_n(res, n_out, res1);
+    int m = f_.checkout();
+    try {
+      for (int i=0; i<n_; ++i) {
+        f_->sp_rev(arg1, res1, iw, w, m);
+        for (int j=0; j<n_in; ++j) {
+          if (arg1[j]) arg1[j] += f_.nnz_in(j);
+        }
+        for (int j=0; j<n_out; ++j) {
+          if (res1[j]) res1[j] += f_.nnz_out(j);
+        }
+      }
+    } catch (...) {
+      f_.release(m);
+      throw;
+    }
+    f_.release(m);
+  }
+
+  void Map::sp_fwd_wide(const bvec_t** arg, bvec_t** res, int* iw, bvec_t* w, int nw) {
+    int n_in = this->n_in(), n_out = this->n_out();
+    const bvec_t** arg1 = arg+n_in;
+    copy_n(arg, n_in, arg1);
+    bvec_t** res1 = res+n_out;
+    copy_n(res, n_out, res1);
+    for (int i=0; i<n_; ++i) {
+      f_->sp_fwd_wide(arg1, res1, iw, w, nw);
+      for (int j=0; j<n_in; ++j) {
+        if (arg1[j]) arg1[j] += f_.nnz_in(j)*nw;
+      }
+      for (int j=0; j<n_out; ++j) {
+        if (res1[j]) res1[j] += f_.nnz_out(j)*nw;
+      }
+    }
+  }
+
+  void Map::sp_rev_wide(bvec_t** arg, bvec_t** res, int* iw, bvec_t* w, int nw) {
     int n_in = this->n_in(), n_out = this->n_out();
     bvec_t** arg1 = arg+n_in;
     copy_n(arg, n_in, arg1);
     bvec_t** res1 = res+n_out;
     copy_n(res, n_out, res1);
     for (int i=0; i<n_; ++i) {
-      f_->sp_rev(arg1, res1, iw, w, 0);
+      f_->sp_rev_wide(arg1, res1, iw, w, nw);
       for (int j=0; j<n_in; ++j) {
-        if (arg1[j]) arg1[j] += f_.nnz_in(j);
+        if (arg1[j]) arg1[j] += f_.nnz_in(j)*nw;
       }
       for (int j=0; j<n_out; ++j) {
-        if (res1[j]) res1[j] += f_.nnz_out(j);
+        if (res1[j]) res1[j] += f_.nnz_out(j)*nw;
       }
     }
   }
@@ -146,7 +223,7 @@ namespace casadi {
 
     // Generate map of derivative
     Function df = f_.forward_new(nfwd);
-    Function dm = df.map(name + "_map", parallelization(), n_, derived_options());
+    Function dm = df.map(name + "_map", parallelization(), n_, map_options());
 
     // Input expressions
     vector<MX> arg = dm.mx_in();
@@ -199,7 +276,7 @@ namespace casadi {
 
     // Generate map of derivative
     Function df = f_.reverse_new(nadj);
-    Function dm = df.map(name + "_map", parallelization(), n_, derived_options());
+    Function dm = df.map(name + "_map", parallelization(), n_, map_options());
 
     // Input expressions
     vector<MX> arg = dm.mx_in();
@@ -244,7 +321,22 @@ namespace casadi {
   }
 
   void Map::eval(void* mem, const double** arg, double** res, int* iw, double* w) const {
-    evalGen(arg, res, iw, w);
+    if (batch_) {
+      f_.get<SXFunction>()->eval_batch(arg, res, iw, w, n_);
+    } else if (batch_mx_) {
+      // Memory object of our own, the batch may contain linear solves
+      const MXFunction* f = f_.get<MXFunction>();
+      int m = f->checkout();
+      try {
+        f->eval_batch(f->memory(m), arg, res, iw, w, n_);
+      } catch (...) {
+        f->release(m);
+        throw;
+      }
+      f->release(m);
+    } else {
+      evalGen(arg, res, iw, w);
+    }
   }
 
   MapOmp::~MapOmp() {
@@ -324,4 +416,309 @@ namespace casadi {
     alloc_iw(f_.sz_iw() * n_);
   }
 
+  Options MapThread::options_
+  = {{&FunctionInternal::options_},
+     {{"n_threads",
+       {OT_INT,
+        "Maximum number of threads, including the calling thread. "
+        "Default: number of hardware threads"}}
+     }
+  };
+
+  MapThread::MapThread(const std::string& name, const Function& f, int n)
+    : Map(name, f, n) {
+    n_threads_ = ThreadPool::default_size();
+  }
+
+  MapThread::~MapThread() {
+  }
+
+  void MapThread::init(const Dict& opts) {
+    // Call the initialization method of the base class
+    Map::init(opts);
+
+    // Read options
+    for (auto&& op : opts) {
+      if (op.first=="n_threads") {
+        n_threads_ = op.second;
+      }
+    }
+    casadi_assert_message(n_threads_>=1, "MapThread: Option \"n_threads\" must be positive");
+
+    // No need for more threads than iterations
+    int nt = std::min(n_threads_, n_);
+
+    // Allocate memory for holding memory object references
+    alloc_iw(nt, true);
+
+    // Allocate sufficient memory for parallel evaluation
+    alloc_arg(f_.sz_arg() * nt);
+    alloc_res(f_.sz_res() * nt);
+    alloc_w(f_.sz_w() * nt);
+    alloc_iw(f_.sz_iw() * nt);
+  }
+
+  void MapThread::eval(void* mem, const double** arg, double** res, int* iw, double* w) const {
+    int n_in = this->n_in(), n_out = this->n_out();
+    size_t sz_arg, sz_res, sz_iw, sz_w;
+    f_.sz_work(sz_arg, sz_res, sz_iw, sz_w);
+    int nt = std::min(n_threads_, n_);
+
+    // Checkout memory objects, one per thread
+    int* ind = iw; iw += nt;
+    for (int k=0; k<nt; ++k) ind[k] = f_.checkout();
+
+    // Evaluate in parallel, each thread using its own work vectors
+    try {
+      ThreadPool::shared().run(n_, [&](int i, int k) {
+        // Input buffers
+        const double** arg1 = arg + n_in + k*sz_arg;
+        for (int j=0; j<n_in; ++j) {
+          arg1[j] = arg[j] ? arg[j] + i*f_.nnz_in(j) : 0;
+        }
+
+        // Output buffers
+        double** res1 = res + n_out + k*sz_res;
+        for (int j=0; j<n_out; ++j) {
+          res1[j] = res[j] ? res[j] + i*f_.nnz_out(j) : 0;
+        }
+
+        // Evaluation
+        f_(arg1, res1, iw + k*sz_iw, w + k*sz_w, ind[k]);
+      }, nt);
+    } catch(...) {
+      for (int k=0; k<nt; ++k) f_.release(ind[k]);
+      throw;
+    }
+
+    // Release memory objects
+    for (int k=0; k<nt; ++k) f_.release(ind[k]);
+  }
+
+  Dict MapThread::map_options() const {
+    Dict opts = Map::map_options();
+    opts["n_threads"] = n_threads_;
+    return opts;
+  }
+
+  Options MapProcess::options_
+  = {{&FunctionInternal::options_},
+     {{"n_processes",
+       {OT_INT,
+        "Number of worker processes. "
+        "Default: number of hardware threads"}}
+     }
+  };
+
+  // Control block at the beginning of the shared memory
+  struct MapProcessControl {
+    // Next iteration to be evaluated
+    std::atomic<int> next;
+  };
+
+  // Inputs that are not null for the current call, one flag per input,
+  // stored right after the control block
+  static int* map_process_has_arg(void* shm) {
+    return reinterpret_cast<int*>(static_cast<char*>(shm) + sizeof(MapProcessControl));
+  }
+
+  MapProcess::MapProcess(const std::string& name, const Function& f, int n)
+    : Map(name, f, n) {
+    n_processes_ = ThreadPool::default_size();
+    shm_ = 0;
+    shm_size_ = 0;
+  }
+
+  MapProcess::~MapProcess() {
+    stop_workers();
+#ifdef CASADI_HAS_MAP_PROCESS
+    if (shm_) munmap(shm_, shm_size_);
+#endif // CASADI_HAS_MAP_PROCESS
+  }
+
+  void MapProcess::init(const Dict& opts) {
+    // Call the initialization method of the base class
+    Map::init(opts);
+
+    // Read options
+    for (auto&& op : opts) {
+      if (op.first=="n_processes") {
+        n_processes_ = op.second;
+      }
+    }
+    casadi_assert_message(n_processes_>=1,
+                          "MapProcess: Option \"n_processes\" must be positive");
+    n_processes_ = std::min(n_processes_, n_);
+
+#ifdef CASADI_HAS_MAP_PROCESS
+    // Layout of the shared memory, with the control block padded to a multiple of 64 bytes
+    int n_in = this->n_in(), n_out = this->n_out();
+    size_t off = (sizeof(MapProcessControl) + n_in*sizeof(int) + 63)/64*64/sizeof(double);
+    off_in_.resize(n_in);
+    for (int j=0; j<n_in; ++j) {
+      off_in_[j] = off;
+      off += nnz_in(j);
+    }
+    off_out_.resize(n_out);
+    for (int j=0; j<n_out; ++j) {
+      off_out_[j] = off;
+      off += nnz_out(j);
+    }
+
+    // Allocate shared memory, inherited by the workers
+    if (shm_) munmap(shm_, shm_size_);
+    shm_size_ = off*sizeof(double);
+    shm_ = mmap(0, shm_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    casadi_assert_message(shm_!=MAP_FAILED, "MapProcess: mmap failed");
+    MapProcessControl* ctrl = new(shm_) MapProcessControl();
+    casadi_assert_message(ctrl->next.is_lock_free(),
+                          "MapProcess: Atomic counter not lock-free, "
+                          "cannot share between processes");
+
+    // Fork the workers now rather than at the first call, when the parent may be
+    // running other threads that hold locks the workers would need
+    stop_workers();
+    start_workers();
+#else // CASADI_HAS_MAP_PROCESS
+    casadi_error("MapProcess: Parallelization \"process\" requires a POSIX platform");
+#endif // CASADI_HAS_MAP_PROCESS
+  }
+
+  void MapProcess::start_workers() {
+#ifdef CASADI_HAS_MAP_PROCESS
+    // Memory object for the workers, checked out in the parent so that the
+    // workers need not lock
+    int mem = f_.checkout();
+    for (int k=0; k<n_processes_; ++k) {
+      int sv[2];
+      casadi_assert_message(socketpair(AF_UNIX, SOCK_STREAM, 0, sv)==0,
+                            "MapProcess: socketpair failed");
+      int pid = fork();
+      if (pid==0) {
+        // Worker: close the sockets belonging to the parent
+        close(sv[0]);
+        for (int fd : fd_) close(fd);
+        worker_loop(sv[1], mem);
+      }
+      close(sv[1]);
+      if (pid<0) {
+        close(sv[0]);
+        f_.release(mem);
+        stop_workers();
+        casadi_error("MapProcess: fork failed");
+      }
+      pid_.push_back(pid);
+      fd_.push_back(sv[0]);
+    }
+    f_.release(mem);
+#endif // CASADI_HAS_MAP_PROCESS
+  }
+
+  void MapProcess::stop_workers() const {
+#ifdef CASADI_HAS_MAP_PROCESS
+    // Tell the workers to exit. Closing the socket is not enough, since it may
+    // have been inherited by workers of other maps.
+    char cmd = 0;
+    for (int fd : fd_) {
+      send(fd, &cmd, 1, MSG_NOSIGNAL);
+      close(fd);
+    }
+    for (int pid : pid_) waitpid(pid, 0, 0);
+    fd_.clear();
+    pid_.clear();
+#endif // CASADI_HAS_MAP_PROCESS
+  }
+
+  void MapProcess::worker_loop(int fd, int mem) const {
+#ifdef CASADI_HAS_MAP_PROCESS
+    int n_in = this->n_in(), n_out = this->n_out();
+    MapProcessControl* ctrl = static_cast<MapProcessControl*>(shm_);
+    const int* has_arg = map_process_has_arg(shm_);
+    double* shm = static_cast<double*>(shm_);
+
+    // Work vectors of the worker
+    std::vector<const double*> arg(f_.sz_arg());
+    std::vector<double*> res(f_.sz_res());
+    std::vector<int> iw(f_.sz_iw());
+    std::vector<double> w(f_.sz_w());
+
+    char cmd;
+    while (recv(fd, &cmd, 1, 0)==1 && cmd!=0) {
+      char status = 0;
+      try {
+        int i;
+        while ((i = ctrl->next++) < n_) {
+          for (int j=0; j<n_in; ++j) {
+            arg[j] = has_arg[j] ? shm + off_in_[j] + i*f_.nnz_in(j) : 0;
+          }
+          for (int j=0; j<n_out; ++j) {
+            res[j] = shm + off_out_[j] + i*f_.nnz_out(j);
+          }
+          f_(get_ptr(arg), get_ptr(res), get_ptr(iw), get_ptr(w), mem);
+        }
+      } catch(std::exception& ex) {
+        userOut<true, PL_WARN>() << name() << ": worker process failed: " << ex.what() << endl;
+        status = 1;
+      }
+      if (send(fd, &status, 1, MSG_NOSIGNAL)!=1) break;
+    }
+
+    // Terminate without running destructors or exit handlers of the parent
+    _exit(0);
+#endif // CASADI_HAS_MAP_PROCESS
+  }
+
+  void MapProcess::eval(void* mem, const double** arg, double** res, int* iw, double* w) const {
+#ifdef CASADI_HAS_MAP_PROCESS
+    int n_in = this->n_in(), n_out = this->n_out();
+    MapProcessControl* ctrl = static_cast<MapProcessControl*>(shm_);
+    int* has_arg = map_process_has_arg(shm_);
+    double* shm = static_cast<double*>(shm_);
+
+    // One call at a time, the shared memory is used by all workers
+    std::lock_guard<std::mutex> lock(mtx_);
+    casadi_assert_message(!pid_.empty(), "MapProcess: Worker processes not running");
+
+    // Copy inputs to shared memory
+    for (int j=0; j<n_in; ++j) {
+      has_arg[j] = arg[j]!=0;
+      if (arg[j]) copy_n(arg[j], nnz_in(j), shm + off_in_[j]);
+    }
+
+    // Start all workers
+    ctrl->next = 0;
+    char cmd = 1, status;
+    for (int fd : fd_) {
+      casadi_assert_message(send(fd, &cmd, 1, MSG_NOSIGNAL)==1,
+                            "MapProcess: Lost connection to worker process");
+    }
+
+    // Wait for completion
+    bool failed = false, lost = false;
+    for (int fd : fd_) {
+      if (recv(fd, &status, 1, 0)!=1) {
+        lost = true;
+      } else if (status!=0) {
+        failed = true;
+      }
+    }
+    if (lost) {
+      stop_workers();
+      casadi_error("MapProcess: Lost connection to worker process");
+    }
+    casadi_assert_message(!failed, "MapProcess: Evaluation failed in worker process");
+
+    // Get outputs from shared memory
+    for (int j=0; j<n_out; ++j) {
+      if (res[j]) copy_n(shm + off_out_[j], nnz_out(j), res[j]);
+    }
+#endif // CASADI_HAS_MAP_PROCESS
+  }
+
+  Dict MapProcess::map_options() const {
+    Dict opts = Map::map_options();
+    opts["n_processes"] = n_processes_;
+    return opts;
+  }
+
 } // namespace casadi
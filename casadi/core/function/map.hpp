@@ -93,6 +93,18 @@ namespace casadi {
     virtual bool has_sprev() const { return true;}
     ///@}
 
+    /** \brief  Can sparsity propagations run concurrently? */
+    virtual bool has_parallel_sp() const { return f_->has_parallel_sp();}
+
+    /** \brief Can several sets of bvec_size directions be propagated in a single pass? */
+    virtual bool has_sp_wide() const { return f_->has_sp_wide();}
+
+    ///@{
+    /** \brief Propagate \a nw sets of directions at once */
+    virtual void sp_fwd_wide(const bvec_t** arg, bvec_t** res, int* iw, bvec_t* w, int nw);
+    virtual void sp_rev_wide(bvec_t** arg, bvec_t** res, int* iw, bvec_t* w, int nw);
+    ///@}
+
     /** \brief Generate code for the declarations of the C function */
     virtual void generateDeclarations(CodeGenerator& g) const;
 
@@ -123,6 +135,9 @@ namespace casadi {
     virtual int get_n_reverse() const { return 64;}
     ///@}
 
+    /** \brief Options for the maps of the derivative functions */
+    virtual Dict map_options() const { return derived_options();}
+
   protected:
     // Constructor (protected, use create function)
     Map(const std::string& name, const Function& f, int n);
@@ -132,6 +147,12 @@ namespace casadi {
 
     // Number of times to evaluate this function
     int n_;
+
+    // Evaluate all instances with a single pass through the SX algorithm
+    bool batch_;
+
+    // Evaluate the MX algorithm one operation at a time for all instances
+    bool batch_mx_;
   };
 
   /** A map Evaluate in parallel using OpenMP
@@ -163,6 +184,107 @@ namespace casadi {
     virtual void generateBody(CodeGenerator& g) const;
   };
 
+  /** A map Evaluate in parallel using the process-wide pool of std::threads
+      Iterations are scheduled dynamically by work stealing, so that iterations of
+      varying cost, e.g. integrators with adaptive step size, are balanced.
+      Work vectors and memory objects are allocated per thread rather than per iteration.
+      All maps share ThreadPool::shared(), with at most n_threads workers per call.
+      Maps nested in the mapped function, and maps called while the pool is busy, are
+      evaluated serially, so that the number of threads does not multiply.
+  */
+  class CASADI_EXPORT MapThread : public Map {
+    friend class Map;
+  protected:
+    // Constructor (protected, use create function in Map)
+    MapThread(const std::string& name, const Function& f, int n);
+
+    /** \brief  Destructor */
+    virtual ~MapThread();
+
+    ///@{
+    /** \brief Options */
+    static Options options_;
+    virtual const Options& get_options() const { return options_;}
+    ///@}
+
+    /// Evaluate the function numerically
+    virtual void eval(void* mem, const double** arg, double** res, int* iw, double* w) const;
+
+    /** \brief  Initialize */
+    virtual void init(const Dict& opts);
+
+    /// Type of parallellization
+    virtual std::string parallelization() const { return "thread"; }
+
+    /** \brief Options for the maps of the derivative functions */
+    virtual Dict map_options() const;
+
+    // Maximum number of threads
+    int n_threads_;
+  };
+
+  /** A map Evaluate in parallel using worker processes
+      The workers are forked during initialization, when the parent is unlikely to run
+      other threads yet, and reused for all calls. Parallel loops inside the workers
+      run serially, the thread pool of the parent is not inherited.
+      Inputs and outputs are exchanged through shared memory and iterations are
+      claimed dynamically through a shared counter. Since every worker has its own
+      copy of the address space, the mapped function need not be thread-safe.
+      Only available on POSIX platforms.
+  */
+  class CASADI_EXPORT MapProcess : public Map {
+    friend class Map;
+  protected:
+    // Constructor (protected, use create function in Map)
+    MapProcess(const std::string& name, const Function& f, int n);
+
+    /** \brief  Destructor */
+    virtual ~MapProcess();
+
+    ///@{
+    /** \brief Options */
+    static Options options_;
+    virtual const Options& get_options() const { return options_;}
+    ///@}
+
+    /// Evaluate the function numerically
+    virtual void eval(void* mem, const double** arg, double** res, int* iw, double* w) const;
+
+    /** \brief  Initialize */
+    virtual void init(const Dict& opts);
+
+    /// Type of parallellization
+    virtual std::string parallelization() const { return "process"; }
+
+    /** \brief Options for the maps of the derivative functions */
+    virtual Dict map_options() const;
+
+    /// Fork the worker processes
+    void start_workers();
+
+    /// Stop the worker processes
+    void stop_workers() const;
+
+    /// Main loop of a worker process, using memory object \a mem of f_, never returns
+    void worker_loop(int fd, int mem) const;
+
+    // Number of worker processes
+    int n_processes_;
+
+    // Shared memory: control block and input flags, followed by all inputs and outputs
+    void* shm_;
+    size_t shm_size_;
+
+    // Offsets of the inputs and outputs in the shared memory (in doubles)
+    std::vector<size_t> off_in_, off_out_;
+
+    // Worker processes and the sockets connecting to them
+    mutable std::vector<int> pid_, fd_;
+
+    // Serializes calls
+    mutable std::mutex mtx_;
+  };
+
 } // namespace casadi
 /// \endcond
 
@@ -27,6 +27,7 @@
 #include "../casadi_types.hpp"
 #include "../global_options.hpp"
 #include "../casadi_interrupt.hpp"
+#include "serializer.hpp"
 
 #include <stack>
 #include <typeinfo>
@@ -43,6 +44,7 @@ namespace casadi {
 
 
   MXFunction::~MXFunction() {
+    clear_memory();
   }
 
   Options MXFunction::options_
@@ -369,8 +371,27 @@ namespace casadi {
     log("MXFunction::init end");
   }
 
+  void MXFunction::init_memory(void* mem) const {
+    auto m = static_cast<MXFunctionMemory*>(mem);
+    // Separate memory objects for the nested calls, allowing concurrent evaluation
+    m->mem.resize(algorithm_.size(), -1);
+    for (int k=0; k<algorithm_.size(); ++k) {
+      const AlgEl& e = algorithm_[k];
+      if (e.op!=OP_INPUT && e.op!=OP_OUTPUT) m->mem[k] = e.data->checkout();
+    }
+  }
+
+  void MXFunction::free_memory(void *mem) const {
+    auto m = static_cast<MXFunctionMemory*>(mem);
+    for (int k=0; k<m->mem.size(); ++k) {
+      if (m->mem[k]>=0) algorithm_[k].data->release(m->mem[k]);
+    }
+    delete m;
+  }
+
   void MXFunction::eval(void* mem, const double** arg, double** res, int* iw, double* w) const {
     casadi_msg("MXFunction::eval():begin "  << name_);
+    auto m = static_cast<MXFunctionMemory*>(mem);
     // Work vector and temporaries to hold pointers to operation input and outputs
     const double** arg1 = arg+n_in();
     double** res1 = res+n_out();
@@ -383,9 +404,17 @@ namespace casadi {
                    << free_vars_ << " are free.");
     }
 
+#ifdef WITH_OPCOUNT
+    OpCount opcount;
+#endif // WITH_OPCOUNT
+
     // Evaluate all of the nodes of the algorithm:
     // should only evaluate nodes that have not yet been calculated!
-    for (auto&& e : algorithm_) {
+    for (int k=0; k<algorithm_.size(); ++k) {
+      const AlgEl& e = algorithm_[k];
+#ifdef WITH_OPCOUNT
+      OpCountTimer opcount_timer(opcount, e.op);
+#endif // WITH_OPCOUNT
       if (e.op==OP_INPUT) {
         // Pass an input
         double *w1 = w+workloc_[e.res.front()];
@@ -410,13 +439,85 @@ namespace casadi {
           res1[i] = e.res[i]>=0 ? w+workloc_[e.res[i]] : 0;
 
         // Evaluate
-        e.data->eval(arg1, res1, iw, w, 0);
+        e.data->eval(arg1, res1, iw, w, m->mem[k]);
       }
     }
 
+#ifdef WITH_OPCOUNT
+    opcount_add(opcount);
+#endif // WITH_OPCOUNT
+
     casadi_msg("MXFunction::eval():end "  << name_);
   }
 
+  void MXFunction::eval_batch(void* mem, const double** arg, double** res, int* iw, double* w,
+                              int n) const {
+    casadi_msg("MXFunction::eval_batch():begin "  << name_);
+    auto m = static_cast<MXFunctionMemory*>(mem);
+    const double** arg1 = arg+n_in();
+    double** res1 = res+n_out();
+
+    // Make sure that there are no free variables
+    if (!free_vars_.empty()) {
+      std::stringstream ss;
+      repr(ss);
+      casadi_error("Cannot evaluate \"" << ss.str() << "\" since variables "
+                   << free_vars_ << " are free.");
+    }
+
+    // Offset between the work vectors of the instances
+    int stride = sz_w();
+
+    // Process the instances in chunks of batch_size
+    for (int offset=0; offset<n; offset+=batch_size) {
+      int nb = std::min(batch_size, n-offset);
+      for (int el=0; el<algorithm_.size(); ++el) {
+        const AlgEl& e = algorithm_[el];
+        if (e.op==OP_INPUT) {
+          // Pass an input
+          int nnz=e.data.nnz();
+          int i=e.arg.at(0);
+          int nz_offset=e.arg.at(2);
+          for (int k=0; k<nb; ++k) {
+            double *w1 = w+k*stride+workloc_[e.res.front()];
+            if (arg[i]==0) {
+              fill(w1, w1+nnz, 0);
+            } else {
+              const double* a = arg[i]+(offset+k)*nnz_in(i)+nz_offset;
+              copy(a, a+nnz, w1);
+            }
+          }
+        } else if (e.op==OP_OUTPUT) {
+          // Get an output
+          int i=e.res.front();
+          if (res[i]==0) continue;
+          for (int k=0; k<nb; ++k) {
+            double *w1 = w+k*stride+workloc_[e.arg.front()];
+            copy(w1, w1+nnz_out(i), res[i]+(offset+k)*nnz_out(i));
+          }
+        } else {
+          // Pointers to the data of the first instance
+          for (int i=0; i<e.arg.size(); ++i)
+            arg1[i] = e.arg[i]>=0 ? w+workloc_[e.arg[i]] : 0;
+          for (int i=0; i<e.res.size(); ++i)
+            res1[i] = e.res[i]>=0 ? w+workloc_[e.res[i]] : 0;
+
+          // Evaluate all instances
+          e.data->eval_batch(arg1, res1, iw, w, nb, stride, m->mem[el]);
+        }
+      }
+    }
+
+    casadi_msg("MXFunction::eval_batch():end "  << name_);
+  }
+
+  bool MXFunction::has_eval_batch() const {
+    for (auto&& e : algorithm_) {
+      if (e.op!=OP_INPUT && e.op!=OP_OUTPUT && e.data->has_eval_batch()) return true;
+    }
+    return false;
+  }
+
   void MXFunction::print(ostream &stream, const AlgEl& el) const {
     if (el.op==OP_OUTPUT) {
       stream << "output[" << el.res.front() << "] = @" << el.arg.at(0);
@@ -548,6 +649,46 @@ namespace casadi {
     }
   }
 
+  bool MXFunction::has_parallel_sp() const {
+    for (auto&& e : algorithm_) {
+      if (e.op!=OP_INPUT && e.op!=OP_OUTPUT && !e.data->has_parallel_sp()) return false;
+    }
+    return true;
+  }
+
+  std::string MXFunction::structure_fingerprint() const {
+    stringstream ss;
+    Serializer s(ss);
+    s.pack(type_name());
+    s.pack(isp_);
+    s.pack(osp_);
+    // Called functions are described at their first call, then referred to by index
+    map<const FunctionInternal*, int> called;
+    for (auto&& e : algorithm_) {
+      s.pack(static_cast<int>(e.op));
+      if (e.op==OP_CALL) {
+        const FunctionInternal* f = e.data->getFunction(0).get();
+        auto it = called.find(f);
+        if (it==called.end()) {
+          string fp = f->structure_fingerprint();
+          if (fp.empty()) return fp;
+          int ind = called.size();
+          called[f] = ind;
+          s.pack(-1);
+          s.pack(fp);
+        } else {
+          s.pack(it->second);
+        }
+      }
+      // The printed operation includes e.g. nonzero mappings
+      stringstream op;
+      print(op, e);
+      s.pack(op.str());
+      if (!e.data.is_null()) s.pack(e.data.sparsity());
+    }
+    return ss.str();
+  }
+
   Function MXFunction::getNumericJacobian(const std::string& name, int iind, int oind,
                                                   bool compact, bool symmetric, const Dict& opts) {
     // Create expressions for the Jacobian
@@ -1326,6 +1467,14 @@ namespace casadi {
     return "mxfunction";
   }
 
+#ifdef WITH_OPCOUNT
+  Dict MXFunction::get_stats(void* mem) const {
+    Dict stats;
+    stats["opcount"] = opcount_stats();
+    return stats;
+  }
+#endif // WITH_OPCOUNT
+
   bool MXFunction::is_a(const std::string& type, bool recursive) const {
     return type=="mxfunction"
       || (recursive && XFunction<MXFunction,
@@ -53,6 +53,12 @@ namespace casadi {
     /// Work vector indices of the results
     std::vector<int> res;
   };
+
+  /** \brief Memory of an MXFunction */
+  struct CASADI_EXPORT MXFunctionMemory {
+    /// Memory objects of the nodes with a state, for each element of the algorithm
+    std::vector<int> mem;
+  };
 #endif // SWIG
 
   /** \brief  Internal node class for MXFunction
@@ -84,9 +90,35 @@ namespace casadi {
     /** \brief  Destructor */
     virtual ~MXFunction();
 
+    /** \brief Create memory block */
+    virtual void* alloc_memory() const { return new MXFunctionMemory();}
+
+    /** \brief Initalize memory block, checking out the memory of the nested calls */
+    virtual void init_memory(void* mem) const;
+
+    /** \brief Free memory block */
+    virtual void free_memory(void *mem) const;
+
     /** \brief  Evaluate numerically, work vectors given */
     virtual void eval(void* mem, const double** arg, double** res, int* iw, double* w) const;
 
+    /** \brief Number of instances processed simultaneously by eval_batch */
+    static const int batch_size = 64;
+
+    /** \brief Evaluate \a n instances, one operation at a time for all instances
+     *
+     * Input j of instance k is found at arg[j] + k*nnz_in(j) and similarly for the
+     * outputs, i.e. the storage format of a horizontally repeated (mapped) function.
+     * Each instance has its own part of the work vector, so that operations such as
+     * linear solves can process all instances in a single call.
+     * Requires sz_w()*batch_size entries in \a w.
+     */
+    void eval_batch(void* mem, const double** arg, double** res, int* iw, double* w,
+                    int n) const;
+
+    /** \brief Does the algorithm contain operations that benefit from eval_batch */
+    bool has_eval_batch() const;
+
     /** \brief  Print description */
     virtual void print(std::ostream &stream) const;
 
@@ -96,6 +128,11 @@ namespace casadi {
     /** \brief Check if the function is of a particular type */
     virtual bool is_a(const std::string& type, bool recursive) const;
 
+#ifdef WITH_OPCOUNT
+    /** \brief Get all statistics */
+    virtual Dict get_stats(void* mem) const;
+#endif // WITH_OPCOUNT
+
     ///@{
     /** \brief Options */
     static Options options_;
@@ -163,6 +200,12 @@ namespace casadi {
     /** \brief  Propagate sparsity backwards */
     virtual void sp_rev(bvec_t** arg, bvec_t** res, int* iw, bvec_t* w, int mem);
 
+    /** \brief  Can sparsity propagations run concurrently? */
+    virtual bool has_parallel_sp() const;
+
+    /** \brief Description of the algorithm and sparsity patterns */
+    virtual std::string structure_fingerprint() const;
+
     // print an element of an algorithm
     void print(std::ostream &stream, const AlgEl& el) const;
 
@@ -0,0 +1,234 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#include "native_jit.hpp"
+#include <cstring>
+#include <limits>
+
+#if defined(__x86_64__) && !defined(_WIN32)
+#define CASADI_HAS_NATIVE_JIT
+#include <sys/mman.h>
+#endif
+
+using namespace std;
+
+namespace casadi {
+
+  // Registers, x86-64 encoding
+  enum {REG_RAX=0, REG_RBX=3, REG_RBP=5, REG_R13=13};
+
+  // Work vector (w) kept in r13, arg in rbx and res in rbp (all callee-saved)
+  static const int REG_ARG = REG_RBX, REG_RES = REG_RBP, REG_W = REG_R13;
+
+  // Scalar double operations, prefix 0xF2
+  enum {SSE_LOAD=0x10, SSE_STORE=0x11, SSE_SQRT=0x51, SSE_ADD=0x58, SSE_MUL=0x59,
+        SSE_SUB=0x5C, SSE_DIV=0x5E};
+
+  // Fallback for operations without a direct machine instruction
+  extern "C" double casadi_native_jit_fun(int op, double x, double y) {
+    double f;
+    casadi_math<double>::fun(op, x, y, f);
+    return f;
+  }
+
+  bool NativeJit::is_supported() {
+#ifdef CASADI_HAS_NATIVE_JIT
+    return true;
+#else // CASADI_HAS_NATIVE_JIT
+    return false;
+#endif // CASADI_HAS_NATIVE_JIT
+  }
+
+  void NativeJit::emit32(int v) {
+    unsigned char b[4];
+    memcpy(b, &v, 4);
+    code_.insert(code_.end(), b, b+4);
+  }
+
+  void NativeJit::emit64(const void* v) {
+    unsigned char b[8];
+    memcpy(b, v, 8);
+    code_.insert(code_.end(), b, b+8);
+  }
+
+  void NativeJit::sse_mem(unsigned char prefix, unsigned char opcode, int xmm, int base,
+                          int disp) {
+    emit(prefix);
+    if (base>=8) emit(0x41); // REX.B
+    emit(0x0F);
+    emit(opcode);
+    emit(0x80 | (xmm << 3) | (base & 7)); // mod=10: [base+disp32]
+    emit32(disp);
+  }
+
+  void NativeJit::load_ptr(int base, int disp) {
+    // mov rax, [base+disp32]
+    emit(base>=8 ? 0x49 : 0x48);
+    emit(0x8B);
+    emit(0x80 | (base & 7));
+    emit32(disp);
+  }
+
+  void NativeJit::load_const(int xmm, double d) {
+    // mov rax, imm64
+    emit(0x48); emit(0xB8); emit64(&d);
+    // movq xmm, rax
+    emit(0x66); emit(0x48); emit(0x0F); emit(0x6E); emit(0xC0 | (xmm << 3));
+  }
+
+  NativeJit::NativeJit(const std::vector<ScalarAtomic>& algorithm)
+    : exec_(0), exec_size_(0), fcn_(0) {
+    casadi_assert_message(is_supported(), "Native just-in-time compilation is only "
+                          "supported on x86-64 platforms with POSIX mmap");
+
+    // Byte offset into the work vector, with overflow check
+    const int max_ind = numeric_limits<int>::max()/sizeof(double);
+    for (auto&& e : algorithm) {
+      casadi_assert_message(e.i0<max_ind && (e.op==OP_CONST || (e.i1<max_ind && e.i2<max_ind)),
+                            "NativeJit: Algorithm too large");
+    }
+
+    // Prologue: push rbx; push rbp; push r13 (stack is now 16-byte aligned)
+    emit(0x53); emit(0x55); emit(0x41); emit(0x55);
+    // mov rbx, rdi; mov rbp, rsi; mov r13, rdx
+    emit(0x48); emit(0x89); emit(0xFB);
+    emit(0x48); emit(0x89); emit(0xF5);
+    emit(0x49); emit(0x89); emit(0xD5);
+
+    // Work vector entry currently held in xmm0 (avoids redundant loads)
+    int cached = -1;
+
+    // Translate the algorithm
+    for (auto&& e : algorithm) {
+      switch (e.op) {
+      case OP_CONST:
+        load_const(0, e.d);
+        sse_mem(0xF2, SSE_STORE, 0, REG_W, 8*e.i0);
+        cached = e.i0;
+        break;
+      case OP_INPUT:
+        {
+          // xorpd xmm0, xmm0
+          emit(0x66); emit(0x0F); emit(0x57); emit(0xC0);
+          load_ptr(REG_ARG, 8*e.i1);
+          // test rax, rax; jz skip
+          emit(0x48); emit(0x85); emit(0xC0);
+          emit(0x74); size_t jmp = code_.size(); emit(0);
+          // movsd xmm0, [rax+8*i2]
+          sse_mem(0xF2, SSE_LOAD, 0, REG_RAX, 8*e.i2);
+          code_[jmp] = static_cast<unsigned char>(code_.size() - jmp - 1);
+          sse_mem(0xF2, SSE_STORE, 0, REG_W, 8*e.i0);
+          cached = e.i0;
+        }
+        break;
+      case OP_OUTPUT:
+        {
+          if (cached!=e.i1) sse_mem(0xF2, SSE_LOAD, 0, REG_W, 8*e.i1);
+          cached = e.i1;
+          load_ptr(REG_RES, 8*e.i0);
+          // test rax, rax; jz skip
+          emit(0x48); emit(0x85); emit(0xC0);
+          emit(0x74); size_t jmp = code_.size(); emit(0);
+          // movsd [rax+8*i2], xmm0
+          sse_mem(0xF2, SSE_STORE, 0, REG_RAX, 8*e.i2);
+          code_[jmp] = static_cast<unsigned char>(code_.size() - jmp - 1);
+        }
+        break;
+      case OP_ADD:
+      case OP_SUB:
+      case OP_MUL:
+      case OP_DIV:
+        {
+          unsigned char opcode = e.op==OP_ADD ? SSE_ADD : e.op==OP_SUB ? SSE_SUB :
+            e.op==OP_MUL ? SSE_MUL : SSE_DIV;
+          if (cached!=e.i1) sse_mem(0xF2, SSE_LOAD, 0, REG_W, 8*e.i1);
+          sse_mem(0xF2, opcode, 0, REG_W, 8*e.i2);
+          sse_mem(0xF2, SSE_STORE, 0, REG_W, 8*e.i0);
+          cached = e.i0;
+        }
+        break;
+      case OP_ASSIGN:
+      case OP_SQ:
+      case OP_TWICE:
+      case OP_NEG:
+        if (cached!=e.i1) sse_mem(0xF2, SSE_LOAD, 0, REG_W, 8*e.i1);
+        if (e.op==OP_SQ) {
+          // mulsd xmm0, xmm0
+          emit(0xF2); emit(0x0F); emit(0x59); emit(0xC0);
+        } else if (e.op==OP_TWICE) {
+          // addsd xmm0, xmm0
+          emit(0xF2); emit(0x0F); emit(0x58); emit(0xC0);
+        } else if (e.op==OP_NEG) {
+          // Flip the sign bit: xorpd xmm0, xmm1
+          load_const(1, -0.);
+          emit(0x66); emit(0x0F); emit(0x57); emit(0xC1);
+        }
+        sse_mem(0xF2, SSE_STORE, 0, REG_W, 8*e.i0);
+        cached = e.i0;
+        break;
+      case OP_SQRT:
+        sse_mem(0xF2, SSE_SQRT, 0, REG_W, 8*e.i1);
+        sse_mem(0xF2, SSE_STORE, 0, REG_W, 8*e.i0);
+        cached = e.i0;
+        break;
+      default:
+        {
+          // Call casadi_native_jit_fun(op, w[i1], w[i2])
+          if (cached!=e.i1) sse_mem(0xF2, SSE_LOAD, 0, REG_W, 8*e.i1);
+          sse_mem(0xF2, SSE_LOAD, 1, REG_W, 8*e.i2);
+          // mov edi, op
+          emit(0xBF); emit32(e.op);
+          // mov rax, imm64; call rax
+          void* fptr = reinterpret_cast<void*>(&casadi_native_jit_fun);
+          emit(0x48); emit(0xB8); emit64(&fptr);
+          emit(0xFF); emit(0xD0);
+          sse_mem(0xF2, SSE_STORE, 0, REG_W, 8*e.i0);
+          cached = e.i0;
+        }
+      }
+    }
+
+    // Epilogue: pop r13; pop rbp; pop rbx; ret
+    emit(0x41); emit(0x5D); emit(0x5D); emit(0x5B); emit(0xC3);
+
+#ifdef CASADI_HAS_NATIVE_JIT
+    // Copy to executable memory
+    exec_size_ = code_.size();
+    exec_ = mmap(0, exec_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    casadi_assert_message(exec_!=MAP_FAILED, "NativeJit: mmap failed");
+    memcpy(exec_, get_ptr(code_), exec_size_);
+    casadi_assert_message(mprotect(exec_, exec_size_, PROT_READ | PROT_EXEC)==0,
+                          "NativeJit: mprotect failed");
+    fcn_ = reinterpret_cast<native_t>(exec_);
+#endif // CASADI_HAS_NATIVE_JIT
+  }
+
+  NativeJit::~NativeJit() {
+#ifdef CASADI_HAS_NATIVE_JIT
+    if (exec_) munmap(exec_, exec_size_);
+#endif // CASADI_HAS_NATIVE_JIT
+  }
+
+} // namespace casadi
@@ -0,0 +1,97 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifndef CASADI_NATIVE_JIT_HPP
+#define CASADI_NATIVE_JIT_HPP
+
+#include "sx_function.hpp"
+
+/// \cond INTERNAL
+
+namespace casadi {
+
+  /** \brief In-process just-in-time compiler for the SXElem virtual machine
+
+      Translates the algorithm of an SXFunction directly into x86-64 machine code,
+      placed in executable memory pages. Operations without a direct SSE2 equivalent
+      are handled by a call back into casadi_math.
+      Only available on x86-64 platforms with POSIX mmap.
+  */
+  class CASADI_EXPORT NativeJit {
+  public:
+    /// Signature of the generated function
+    typedef void (*native_t)(const double** arg, double** res, double* w);
+
+    /// Constructor, generates the machine code
+    explicit NativeJit(const std::vector<ScalarAtomic>& algorithm);
+
+    /// Destructor, frees the executable memory
+    ~NativeJit();
+
+    /// Is native code generation supported on this platform?
+    static bool is_supported();
+
+    /// Get a pointer to the generated function
+    native_t fcn() const { return fcn_;}
+
+    /// Size of the generated code in bytes
+    size_t size() const { return code_.size();}
+
+  private:
+    // Copying not allowed
+    NativeJit(const NativeJit&);
+    NativeJit& operator=(const NativeJit&);
+
+    ///@{
+    /// Emit machine code
+    void emit(unsigned char b) { code_.push_back(b);}
+    void emit32(int v);
+    void emit64(const void* v);
+    ///@}
+
+    /// SSE2 instruction with a memory operand [base+disp32]
+    void sse_mem(unsigned char prefix, unsigned char opcode, int xmm, int base, int disp);
+
+    /// Load a pointer from [base+disp32] into rax
+    void load_ptr(int base, int disp);
+
+    /// Load a double constant into an xmm register
+    void load_const(int xmm, double d);
+
+    /// Machine code
+    std::vector<unsigned char> code_;
+
+    /// Executable memory
+    void* exec_;
+    size_t exec_size_;
+
+    /// Function pointer to the executable memory
+    native_t fcn_;
+  };
+
+} // namespace casadi
+
+/// \endcond
+#endif // CASADI_NATIVE_JIT_HPP
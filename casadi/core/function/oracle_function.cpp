@@ -184,15 +184,18 @@ namespace casadi {
       }
     }
 
-    // Evaluate memory-less
+    // Evaluate with a memory object of its own, allowing concurrent calls
+    int mem = f.checkout();
     try {
-      f(m->arg, m->res, m->iw, m->w, 0);
+      f(m->arg, m->res, m->iw, m->w, mem);
     } catch(exception& ex) {
+      f.release(mem);
       // Fatal error
       userOut<true, PL_WARN>()
         << name() << ":" << fcn << " failed:" << ex.what() << endl;
       return 1;
     }
+    f.release(mem);
 
     // Print output nonzeros
     if (monitored) {
@@ -169,8 +169,16 @@ Function Function::rootfinder_fun() {
 
   void Rootfinder::init_memory(void* mem) const {
     OracleFunction::init_memory(mem);
-    //auto m = static_cast<RootfinderMemory*>(mem);
-    linsol_.reset(sp_jac_);
+    auto m = static_cast<RootfinderMemory*>(mem);
+
+    // Separate factorization for each memory object, allowing concurrent calls
+    m->linsol_mem = linsol_.checkout();
+    linsol_.reset(sp_jac_, m->linsol_mem);
+  }
+
+  void Rootfinder::free_memory(void *mem) const {
+    auto m = static_cast<RootfinderMemory*>(mem);
+    if (m->linsol_mem>=0) linsol_.release(m->linsol_mem);
   }
 
   void Rootfinder::eval(void* mem, const double** arg, double** res, int* iw, double* w) const {
@@ -40,6 +40,11 @@ namespace casadi {
 
     // Outputs
     double** ires;
+
+    // Memory object of the linear solver
+    int linsol_mem;
+
+    RootfinderMemory() : linsol_mem(-1) {}
   };
 
   /// Internal class
@@ -84,6 +89,9 @@ namespace casadi {
     /** \brief Initalize memory block */
     virtual void init_memory(void* mem) const;
 
+    /** \brief Release the memory of the linear solver, the plugin deletes the block */
+    virtual void free_memory(void *mem) const;
+
     /** \brief Set the (persistent) work vectors */
     virtual void set_work(void* mem, const double**& arg, double**& res,
                           int*& iw, double*& w) const;
@@ -0,0 +1,111 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#include "serializer.hpp"
+
+using namespace std;
+
+namespace casadi {
+
+  void Serializer::write(const void* data, size_t sz) {
+    out_.write(static_cast<const char*>(data), sz);
+    casadi_assert_message(out_.good(), "Serializer: Write failed");
+  }
+
+  void Serializer::pack(int e) {
+    write(&e, sizeof(e));
+  }
+
+  void Serializer::pack(double e) {
+    write(&e, sizeof(e));
+  }
+
+  void Serializer::pack(const std::string& e) {
+    pack(static_cast<int>(e.size()));
+    write(e.data(), e.size());
+  }
+
+  void Serializer::pack(const std::vector<int>& e) {
+    pack(static_cast<int>(e.size()));
+    if (!e.empty()) write(get_ptr(e), e.size()*sizeof(int));
+  }
+
+  void Serializer::pack(const std::vector<double>& e) {
+    pack(static_cast<int>(e.size()));
+    if (!e.empty()) write(get_ptr(e), e.size()*sizeof(double));
+  }
+
+  void Serializer::pack(const Sparsity& e) {
+    if (e.is_null()) {
+      pack(std::vector<int>());
+    } else {
+      pack(e.compress());
+    }
+  }
+
+  void Deserializer::read(void* data, size_t sz) {
+    in_.read(static_cast<char*>(data), sz);
+    casadi_assert_message(in_.good(), "Deserializer: Unexpected end of data");
+  }
+
+  void Deserializer::unpack(int& e) {
+    read(&e, sizeof(e));
+  }
+
+  void Deserializer::unpack(double& e) {
+    read(&e, sizeof(e));
+  }
+
+  void Deserializer::unpack(std::string& e) {
+    int sz;
+    unpack(sz);
+    casadi_assert_message(sz>=0, "Deserializer: Corrupt data");
+    e.resize(sz);
+    if (sz>0) read(&e[0], sz);
+  }
+
+  void Deserializer::unpack(std::vector<int>& e) {
+    int sz;
+    unpack(sz);
+    casadi_assert_message(sz>=0, "Deserializer: Corrupt data");
+    e.resize(sz);
+    if (sz>0) read(get_ptr(e), sz*sizeof(int));
+  }
+
+  void Deserializer::unpack(std::vector<double>& e) {
+    int sz;
+    unpack(sz);
+    casadi_assert_message(sz>=0, "Deserializer: Corrupt data");
+    e.resize(sz);
+    if (sz>0) read(get_ptr(e), sz*sizeof(double));
+  }
+
+  void Deserializer::unpack(Sparsity& e) {
+    std::vector<int> v;
+    unpack(v);
+    e = v.empty() ? Sparsity() : Sparsity::compressed(v);
+  }
+
+} // namespace casadi
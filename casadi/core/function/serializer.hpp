@@ -0,0 +1,108 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifndef CASADI_SERIALIZER_HPP
+#define CASADI_SERIALIZER_HPP
+
+#include "../sparsity.hpp"
+#include <iostream>
+
+/// \cond INTERNAL
+
+namespace casadi {
+
+  /** \brief Helper class for writing functions in a compact binary format
+
+      Scalars are written in native byte order, so files are only portable
+      between platforms of the same endianness and word size.
+  */
+  class CASADI_EXPORT Serializer {
+  public:
+    /// Constructor
+    explicit Serializer(std::ostream& out) : out_(out) {}
+
+    ///@{
+    /// Write an entry
+    void pack(int e);
+    void pack(double e);
+    void pack(const std::string& e);
+    void pack(const Sparsity& e);
+    void pack(const std::vector<int>& e);
+    void pack(const std::vector<double>& e);
+    template<typename T>
+    void pack(const std::vector<T>& e) {
+      pack(static_cast<int>(e.size()));
+      for (auto&& i : e) pack(i);
+    }
+    ///@}
+
+    /// Write raw data
+    void write(const void* data, size_t sz);
+
+  private:
+    std::ostream& out_;
+  };
+
+  /** \brief Helper class for reading functions written by Serializer
+  */
+  class CASADI_EXPORT Deserializer {
+  public:
+    /// Constructor
+    explicit Deserializer(std::istream& in) : in_(in) {}
+
+    ///@{
+    /// Read an entry
+    void unpack(int& e);
+    void unpack(double& e);
+    void unpack(std::string& e);
+    void unpack(Sparsity& e);
+    void unpack(std::vector<int>& e);
+    void unpack(std::vector<double>& e);
+    template<typename T>
+    void unpack(std::vector<T>& e) {
+      int sz;
+      unpack(sz);
+      casadi_assert_message(sz>=0, "Deserializer: Corrupt data");
+      e.resize(sz);
+      for (int i=0; i<sz; ++i) {
+        T v;
+        unpack(v);
+        e[i] = v;
+      }
+    }
+    ///@}
+
+    /// Read raw data
+    void read(void* data, size_t sz);
+
+  private:
+    std::istream& in_;
+  };
+
+} // namespace casadi
+
+/// \endcond
+
+#endif // CASADI_SERIALIZER_HPP
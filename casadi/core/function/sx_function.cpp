@@ -24,6 +24,8 @@
 
 
 #include "sx_function.hpp"
+#include "native_jit.hpp"
+#include "serializer.hpp"
 #include <limits>
 #include <stack>
 #include <deque>
@@ -32,15 +34,36 @@
 #include <iomanip>
 #include "../std_vector_tools.hpp"
 #include "../sx/sx_node.hpp"
+#include "../sx/unary_sx.hpp"
+#include "../sx/binary_sx.hpp"
 #include "../casadi_types.hpp"
 #include "../sparsity_internal.hpp"
 #include "../global_options.hpp"
 #include "../casadi_interrupt.hpp"
+#include <unordered_map>
 
 namespace casadi {
 
   using namespace std;
 
+  /// Structural identity of a node, used for common subexpression elimination
+  struct SXCseKey {
+    int op;
+    long long a, b;
+    bool operator==(const SXCseKey& k) const { return op==k.op && a==k.a && b==k.b;}
+  };
+
+  /// Hash function for SXCseKey
+  struct SXCseHash {
+    size_t operator()(const SXCseKey& k) const {
+      size_t seed = 0;
+      hash_combine(seed, k.op);
+      hash_combine(seed, k.a);
+      hash_combine(seed, k.b);
+      return seed;
+    }
+  };
+
 
   SXFunction::SXFunction(const std::string& name,
                                          const vector<SX >& inputv,
@@ -60,9 +83,14 @@ namespace casadi {
     // Default (persistent) options
     just_in_time_opencl_ = false;
     just_in_time_sparsity_ = false;
+    just_in_time_native_ = false;
+    native_jit_ = 0;
+    n_cse_ = 0;
   }
 
   SXFunction::~SXFunction() {
+    if (native_jit_) delete native_jit_;
+
     // Free OpenCL memory
 #ifdef WITH_OPENCL
     freeOpenCL();
@@ -81,12 +109,26 @@ namespace casadi {
                    << free_vars_ << " are free.");
     }
 
+    // Use the generated machine code, if available
+    if (native_jit_) {
+      native_jit_->fcn()(arg, res, w);
+      casadi_msg("SXFunction::eval():end " << name_);
+      return;
+    }
+
     // NOTE: The implementation of this function is very delicate. Small changes in the
     // class structure can cause large performance losses. For this reason,
     // the preprocessor macros are used below
 
+#ifdef WITH_OPCOUNT
+    OpCount opcount;
+#endif // WITH_OPCOUNT
+
     // Evaluate the algorithm
     for (auto&& e : algorithm_) {
+#ifdef WITH_OPCOUNT
+      OpCountTimer opcount_timer(opcount, e.op);
+#endif // WITH_OPCOUNT
       switch (e.op) {
         CASADI_MATH_FUN_BUILTIN(w[e.i1], w[e.i2], w[e.i0])
 
@@ -98,12 +140,287 @@ namespace casadi {
       }
     }
 
+#ifdef WITH_OPCOUNT
+    opcount_add(opcount);
+#endif // WITH_OPCOUNT
+
     casadi_msg("SXFunction::eval():end " << name_);
   }
 
+  void SXFunction::eval_batch(const double** arg, double** res, int* iw, double* w,
+                              int n) const {
+    casadi_msg("SXFunction::eval_batch():begin  " << name_);
+
+    // Make sure no free parameters
+    if (!free_vars_.empty()) {
+      std::stringstream ss;
+      repr(ss);
+      casadi_error("Cannot evaluate \"" << ss.str() << "\" since variables "
+                   << free_vars_ << " are free.");
+    }
+
+    // Number of lanes, known at compile time so that the loops can be vectorized
+    const int L = batch_size;
+
+    // Process the instances in chunks of L
+    for (int offset=0; offset<n; offset+=L) {
+      // Number of active lanes, the remaining lanes are evaluated but discarded
+      int nl = std::min(L, n-offset);
+
+      // Evaluate the algorithm
+      for (auto&& e : algorithm_) {
+        double* f = w + e.i0*L;
+        switch (e.op) {
+          CASADI_MATH_FUN_BUILTIN_GEN(BinaryOperationVV, w + e.i1*L, w + e.i2*L, f, L)
+
+        case OP_CONST:
+          std::fill(f, f+L, e.d);
+          break;
+        case OP_INPUT:
+          if (arg[e.i1]==0) {
+            std::fill(f, f+L, 0);
+          } else {
+            int nnz = nnz_in(e.i1);
+            const double* a = arg[e.i1] + offset*nnz + e.i2;
+            for (int k=0; k<nl; ++k) f[k] = a[k*nnz];
+            std::fill(f+nl, f+L, 0);
+          }
+          break;
+        case OP_OUTPUT:
+          if (res[e.i0]!=0) {
+            int nnz = nnz_out(e.i0);
+            double* r = res[e.i0] + offset*nnz + e.i2;
+            const double* v = w + e.i1*L;
+            for (int k=0; k<nl; ++k) r[k*nnz] = v[k];
+          }
+          break;
+        default:
+          casadi_error("SXFunction::eval_batch: Unknown operation" << e.op);
+        }
+      }
+    }
+
+    casadi_msg("SXFunction::eval_batch():end " << name_);
+  }
+
+
+  /** \brief Second order partial derivatives of an atomic operation, false if not available
+
+      Piecewise constant derivatives, e.g. of fmax, are not available: the Jacobian of the
+      gradient keeps their dependencies in the sparsity pattern, edge pushing would not
+  */
+  static bool hess_partials(int op, const SXElem& x, const SXElem& y, const SXElem& f,
+                            SXElem* d2) {
+    // d2[0] = d^2f/dx^2, d2[1] = d^2f/dxdy, d2[2] = d^2f/dy^2
+    d2[0] = d2[1] = d2[2] = 0;
+    switch (op) {
+    case OP_ASSIGN: case OP_ADD: case OP_SUB: case OP_NEG: case OP_TWICE:
+    case OP_LIFT: case OP_PRINTME:
+      // Linear
+      return true;
+    case OP_MUL: d2[1] = 1; return true;
+    case OP_DIV: d2[1] = -1/(y*y); d2[2] = 2*f/(y*y); return true;
+    case OP_EXP: d2[0] = f; return true;
+    case OP_LOG: d2[0] = -1/(x*x); return true;
+    case OP_POW:
+      d2[0] = y*(y-1)*pow(x, y-2);
+      d2[1] = pow(x, y-1)*(1+y*log(x));
+      d2[2] = f*log(x)*log(x);
+      return true;
+    case OP_CONSTPOW: d2[0] = y*(y-1)*pow(x, y-2); return true;
+    case OP_SQRT: d2[0] = -1/(4*f*x); return true;
+    case OP_SQ: d2[0] = 2; return true;
+    case OP_SIN: d2[0] = -f; return true;
+    case OP_COS: d2[0] = -f; return true;
+    case OP_TAN: d2[0] = 2*f*(1+f*f); return true;
+    case OP_ASIN: d2[0] = x/((1-x*x)*sqrt(1-x*x)); return true;
+    case OP_ACOS: d2[0] = -x/((1-x*x)*sqrt(1-x*x)); return true;
+    case OP_ATAN: d2[0] = -2*x/((1+x*x)*(1+x*x)); return true;
+    case OP_ERF: d2[0] = -2*x*(2/sqrt(pi))*exp(-x*x); return true;
+    case OP_INV: d2[0] = 2*f*f*f; return true;
+    case OP_SINH: d2[0] = f; return true;
+    case OP_COSH: d2[0] = f; return true;
+    case OP_TANH: d2[0] = -2*f*(1-f*f); return true;
+    case OP_ASINH: d2[0] = -x/((1+x*x)*sqrt(1+x*x)); return true;
+    case OP_ACOSH: d2[0] = -x/((x*x-1)*sqrt(x*x-1)); return true;
+    case OP_ATANH: d2[0] = 2*x/((1-x*x)*(1-x*x)); return true;
+    case OP_ATAN2:
+      {
+        SXElem t = x*x+y*y;
+        d2[0] = -2*x*y/(t*t);
+        d2[1] = (x*x-y*y)/(t*t);
+        d2[2] = 2*x*y/(t*t);
+      }
+      return true;
+    case OP_ERFINV:
+      {
+        SXElem d = (sqrt(pi)/2)*exp(f*f);
+        d2[0] = 2*f*d*d;
+      }
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  bool SXFunction::hess_edge_pushing(int iind, int oind, SX& H) const {
+    // Nonlinear interactions are accumulated on a symmetric graph over the nodes of
+    // the algorithm in a single reverse sweep, cf. Gower & Mello (2012)
+    int nalg = algorithm_.size();
+
+    // Node defining each element of the work vector
+    vector<int> def(sz_w(), -1);
+
+    // Dependencies of each node on nodes that depend on input iind, -1 if none
+    vector<int> dep0(nalg, -1), dep1(nalg, -1);
+    vector<bool> active(nalg, false);
+
+    // First and second order partial derivatives of each node
+    vector<SXElem> d1(2*nalg), d2(3*nalg);
+
+    // Node which is seeded and input nonzero corresponding to each input node
+    int seed = -1;
+    vector<int> input_nz(nalg, -1);
+
+    // Forward sweep: record the graph and the partial derivatives
+    vector<SXElem>::const_iterator b_it=operations_.begin();
+    for (int k=0; k<nalg; ++k) {
+      const AlgEl& e = algorithm_[k];
+      switch (e.op) {
+      case OP_OUTPUT:
+        if (e.i0==oind) seed = def[e.i1];
+        continue;
+      case OP_INPUT:
+        if (e.i1==iind) {
+          active[k] = true;
+          input_nz[k] = e.i2;
+        }
+        break;
+      case OP_CONST:
+      case OP_PARAMETER:
+        break;
+      default:
+        {
+          const SXElem& f=*b_it++;
+          if (!hess_partials(e.op, f->dep(0), f->dep(1), f, &d2[3*k])) return false;
+          casadi_math<SXElem>::der(e.op, f->dep(0), f->dep(1), f, &d1[2*k]);
+          if (active[def[e.i1]]) dep0[k] = def[e.i1];
+          if (casadi_math<SXElem>::ndeps(e.op)==2 && active[def[e.i2]]) {
+            if (dep0[k]==def[e.i2]) {
+              // Same node in both arguments
+              d1[2*k] += d1[2*k+1];
+              d2[3*k] += 2*d2[3*k+1] + d2[3*k+2];
+            } else {
+              dep1[k] = def[e.i2];
+            }
+          }
+          active[k] = dep0[k]>=0 || dep1[k]>=0;
+        }
+      }
+      def[e.i0] = k;
+    }
+
+    // Adjoint of each node and symmetric graph of nonlinear interactions
+    vector<SXElem> adj(nalg, 0);
+    vector<map<int, SXElem> > W(nalg);
+    if (seed>=0 && active[seed]) adj[seed] = 1;
+
+    // Add a contribution to an edge of the graph
+    std::function<void(int, int, const SXElem&)> add_edge([&](int a, int b, const SXElem& v) {
+      // Default constructed SXElem is nan, initialize with zero
+      W[a].insert(make_pair(b, SXElem(0))).first->second += v;
+      if (a!=b) W[b].insert(make_pair(a, SXElem(0))).first->second += v;
+    });
+
+    // Reverse sweep
+    vector<pair<int, SXElem> > edges;
+    for (int k=nalg-1; k>=0; --k) {
+      if (!active[k] || input_nz[k]>=0) continue;
+
+      // Active dependencies and their first order partial derivatives
+      int nd = 0;
+      int dep[2];
+      SXElem pd[2];
+      if (dep0[k]>=0) {
+        dep[nd] = dep0[k];
+        pd[nd++] = d1[2*k];
+      }
+      if (dep1[k]>=0) {
+        dep[nd] = dep1[k];
+        pd[nd++] = d1[2*k+1];
+      }
+
+      // Remove the edges of the node from the graph
+      edges.assign(W[k].begin(), W[k].end());
+      W[k].clear();
+      for (auto&& ee : edges) if (ee.first!=k) W[ee.first].erase(k);
+
+      // Pushing: propagate the edges to the dependencies
+      for (auto&& ee : edges) {
+        if (ee.second.is_zero()) continue;
+        if (ee.first==k) {
+          for (int i=0; i<nd; ++i) {
+            for (int j=0; j<=i; ++j) {
+              add_edge(dep[i], dep[j], pd[i]*pd[j]*ee.second);
+            }
+          }
+        } else {
+          for (int i=0; i<nd; ++i) {
+            if (dep[i]==ee.first) {
+              add_edge(dep[i], dep[i], 2*pd[i]*ee.second);
+            } else {
+              add_edge(dep[i], ee.first, pd[i]*ee.second);
+            }
+          }
+        }
+      }
+
+      // Creating: add the nonlinear interactions of the node itself
+      if (!adj[k].is_zero()) {
+        for (int i=0; i<nd; ++i) {
+          const SXElem& d2ii = d2[dep[i]==dep0[k] ? 3*k : 3*k+2];
+          if (!d2ii.is_zero()) add_edge(dep[i], dep[i], adj[k]*d2ii);
+        }
+        if (nd==2 && !d2[3*k+1].is_zero()) add_edge(dep[0], dep[1], adj[k]*d2[3*k+1]);
+      }
+
+      // Adjoint propagation
+      if (!adj[k].is_zero()) {
+        for (int i=0; i<nd; ++i) adj[dep[i]] += adj[k]*pd[i];
+      }
+    }
+
+    // Collect the edges between nonzeros of input iind
+    const Sparsity& sp = sparsity_in(iind);
+    vector<int> lin = sp.find();
+    vector<int> row, col;
+    vector<SXElem> nz;
+    for (int k=0; k<nalg; ++k) {
+      if (input_nz[k]<0) continue;
+      for (auto&& ee : W[k]) {
+        if (input_nz[ee.first]<0) continue;
+        row.push_back(lin[input_nz[k]]);
+        col.push_back(lin[input_nz[ee.first]]);
+        nz.push_back(ee.second);
+      }
+    }
+    vector<int> mapping;
+    Sparsity Hsp = Sparsity::triplet(sp.numel(), sp.numel(), row, col, mapping, true);
+    H = SX::zeros(Hsp);
+    for (int k=0; k<mapping.size(); ++k) H->at(mapping[k]) += nz[k];
+    return true;
+  }
 
   SX SXFunction::hess(int iind, int oind) {
     casadi_assert_message(sparsity_out(oind).is_scalar(false), "Function must be scalar");
+
+    // Construct the Hessian directly if all operations have second order derivatives
+    SX H;
+    if (hess_edge_pushing(iind, oind, H)) {
+      if (verbose()) userOut() << "SXFunction::hess: edge pushing done " << endl;
+      return H;
+    }
+
     SX g = densify(grad(iind, oind));
     if (verbose())  userOut() << "SXFunction::hess: calculating gradient done " << endl;
 
@@ -242,9 +559,17 @@ namespace casadi {
       {"just_in_time_opencl",
        {OT_BOOL,
         "Just-in-time compilation for numeric evaluation using OpenCL (experimental)"}},
+      {"just_in_time_native",
+       {OT_BOOL,
+        "Just-in-time compilation for numeric evaluation directly to x86-64 "
+        "machine code, without invoking an external compiler (experimental)"}},
       {"live_variables",
        {OT_BOOL,
-        "Reuse variables in the work vector"}}
+        "Reuse variables in the work vector"}},
+      {"cse",
+       {OT_BOOL,
+        "Perform common subexpression elimination, i.e. merge structurally "
+        "identical nodes in the expression graph"}}
      }
   };
 
@@ -255,6 +580,7 @@ namespace casadi {
 
     // Default (temporary) options
     bool live_variables = true;
+    bool cse = false;
 
     // Read options
     for (auto&& op : opts) {
@@ -262,10 +588,14 @@ namespace casadi {
         default_in_ = op.second;
       } else if (op.first=="live_variables") {
         live_variables = op.second;
+      } else if (op.first=="cse") {
+        cse = op.second;
       } else if (op.first=="just_in_time_opencl") {
         just_in_time_opencl_ = op.second;
       } else if (op.first=="just_in_time_sparsity") {
         just_in_time_sparsity_ = op.second;
+      } else if (op.first=="just_in_time_native") {
+        just_in_time_native_ = op.second;
       }
     }
 
@@ -304,6 +634,55 @@ namespace casadi {
       }
     }
 
+    // Nodes that are identical to an earlier node in the sorted graph
+    vector<SXNode*> duplicates;
+
+    // Common subexpression elimination
+    if (cse) {
+      // The first occurrence of each unique expression
+      unordered_map<SXCseKey, int, SXCseHash> unique;
+
+      // Since the nodes are sorted, the dependencies have already been visited
+      int n_unique = 0;
+      for (int i=0; i<nodes.size(); ++i) {
+        SXNode* t = nodes[i];
+        if (t && !t->is_symbolic()) {
+          SXCseKey key;
+          key.op = t->op();
+          if (t->is_constant()) {
+            double v = t->to_double();
+            memcpy(&key.a, &v, sizeof(double));
+            key.b = 0;
+          } else {
+            // Location of the dependencies, (possibly) remapped
+            key.a = t->dep(0).get()->temp;
+            key.b = t->ndep()==1 ? key.a : t->dep(1).get()->temp;
+            if (operation_checker<CommChecker>(key.op) && key.a>key.b) swap(key.a, key.b);
+          }
+
+          // Refer to the first occurrence, if any
+          auto it = unique.find(key);
+          if (it!=unique.end()) {
+            t->temp = it->second;
+            duplicates.push_back(t);
+            continue;
+          }
+          unique.insert(make_pair(key, n_unique));
+        }
+
+        // Keep node
+        if (t) t->temp = n_unique;
+        nodes[n_unique++] = t;
+      }
+      nodes.resize(n_unique);
+
+      if (verbose()) {
+        userOut() << "SXFunction::init: common subexpression elimination removed "
+                  << duplicates.size() << " nodes" << endl;
+      }
+    }
+    n_cse_ = duplicates.size();
+
     // Sort the nodes by type
     constants_.clear();
     operations_.clear();
@@ -458,6 +837,7 @@ namespace casadi {
         nodes[i]->temp = 0;
       }
     }
+    for (auto&& t : duplicates) t->temp = 0;
 
     // Now mark each input's place in the algorithm
     for (auto it=symb_loc.begin(); it!=symb_loc.end(); ++it) {
@@ -518,6 +898,19 @@ namespace casadi {
 #endif // WITH_OPENCL
     }
 
+    // Initialize just-in-time compilation to native machine code
+    if (just_in_time_native_ && free_vars_.empty()) {
+      casadi_assert_message(NativeJit::is_supported(),
+                            "Option \"just_in_time_native\" true is only supported "
+                            "on x86-64 platforms");
+      if (native_jit_) delete native_jit_;
+      native_jit_ = new NativeJit(algorithm_);
+      if (verbose()) {
+        userOut() << "SXFunction::init Generated " << native_jit_->size()
+                  << " bytes of machine code" << endl;
+      }
+    }
+
     // Print
     if (verbose()) {
       userOut() << "SXFunction::init Initialized " << name_ << " ("
@@ -826,6 +1219,100 @@ namespace casadi {
     }
   }
 
+  template<int NW>
+  void SXFunction::sp_fwd_wide_gen(const bvec_t** arg, bvec_t** res, bvec_t* w, int nw) const {
+    // Words per nonzero, known at compile time if NW is nonzero
+    const int n = NW>0 ? NW : nw;
+
+    // Propagate sparsity forward
+    for (auto&& e : algorithm_) {
+      switch (e.op) {
+      case OP_CONST:
+      case OP_PARAMETER:
+        fill_n(w + e.i0*n, n, 0); break;
+      case OP_INPUT:
+        if (arg[e.i1]==0) {
+          fill_n(w + e.i0*n, n, 0);
+        } else {
+          copy_n(arg[e.i1] + e.i2*n, n, w + e.i0*n);
+        }
+        break;
+      case OP_OUTPUT:
+        if (res[e.i0]!=0) copy_n(w + e.i1*n, n, res[e.i0] + e.i2*n);
+        break;
+      default: // Unary or binary operation
+        {
+          bvec_t* f = w + e.i0*n;
+          const bvec_t *x = w + e.i1*n, *y = w + e.i2*n;
+          for (int k=0; k<n; ++k) f[k] = x[k] | y[k];
+        }
+      }
+    }
+  }
+
+  template<int NW>
+  void SXFunction::sp_rev_wide_gen(bvec_t** arg, bvec_t** res, bvec_t* w, int nw) const {
+    // Words per nonzero, known at compile time if NW is nonzero
+    const int n = NW>0 ? NW : nw;
+    fill_n(w, sz_w()*n, 0);
+
+    // Propagate sparsity backward
+    for (auto it=algorithm_.rbegin(); it!=algorithm_.rend(); ++it) {
+      switch (it->op) {
+      case OP_CONST:
+      case OP_PARAMETER:
+        fill_n(w + it->i0*n, n, 0);
+        break;
+      case OP_INPUT:
+        if (arg[it->i1]!=0) {
+          bvec_t* a = arg[it->i1] + it->i2*n;
+          const bvec_t* f = w + it->i0*n;
+          for (int k=0; k<n; ++k) a[k] |= f[k];
+        }
+        fill_n(w + it->i0*n, n, 0);
+        break;
+      case OP_OUTPUT:
+        if (res[it->i0]!=0) {
+          bvec_t* r = res[it->i0] + it->i2*n;
+          bvec_t* x = w + it->i1*n;
+          for (int k=0; k<n; ++k) {
+            x[k] |= r[k];
+            r[k] = 0;
+          }
+        }
+        break;
+      default: // Unary or binary operation
+        {
+          bvec_t *f = w + it->i0*n, *x = w + it->i1*n, *y = w + it->i2*n;
+          for (int k=0; k<n; ++k) {
+            bvec_t seed = f[k];
+            f[k] = 0;
+            x[k] |= seed;
+            y[k] |= seed;
+          }
+        }
+      }
+    }
+  }
+
+  void SXFunction::sp_fwd_wide(const bvec_t** arg, bvec_t** res, int* iw, bvec_t* w, int nw) {
+    switch (nw) {
+    case 2: return sp_fwd_wide_gen<2>(arg, res, w, nw);
+    case 4: return sp_fwd_wide_gen<4>(arg, res, w, nw);
+    case 8: return sp_fwd_wide_gen<8>(arg, res, w, nw);
+    default: return sp_fwd_wide_gen<0>(arg, res, w, nw);
+    }
+  }
+
+  void SXFunction::sp_rev_wide(bvec_t** arg, bvec_t** res, int* iw, bvec_t* w, int nw) {
+    switch (nw) {
+    case 2: return sp_rev_wide_gen<2>(arg, res, w, nw);
+    case 4: return sp_rev_wide_gen<4>(arg, res, w, nw);
+    case 8: return sp_rev_wide_gen<8>(arg, res, w, nw);
+    default: return sp_rev_wide_gen<0>(arg, res, w, nw);
+    }
+  }
+
   Function SXFunction::getFullJacobian() {
     SX J = SX::jacobian(veccat(out_), veccat(in_));
     return Function(name_ + "_jac", in_, {J});
@@ -1406,6 +1893,136 @@ namespace casadi {
     return in_;
   }
 
+  void SXFunction::serialize(Serializer& s) const {
+    s.pack(name());
+    s.pack(ischeme_);
+    s.pack(oscheme_);
+    s.pack(isp_);
+    s.pack(osp_);
+
+    // Names of the symbolic primitives
+    for (auto&& i : in_) {
+      vector<string> names;
+      for (auto&& e : i.nonzeros()) names.push_back(e.name());
+      s.pack(names);
+    }
+    vector<string> free_names;
+    for (auto&& e : free_vars_) free_names.push_back(e.name());
+    s.pack(free_names);
+    s.pack(default_in_);
+
+    // Algorithm, raw
+    s.pack(static_cast<int>(sz_w()));
+    s.pack(static_cast<int>(algorithm_.size()));
+    s.write(get_ptr(algorithm_), algorithm_.size()*sizeof(AlgEl));
+  }
+
+  Function SXFunction::deserialize(Deserializer& s, const Dict& opts) {
+    string name;
+    vector<string> name_in, name_out;
+    vector<Sparsity> sp_in, sp_out;
+    s.unpack(name);
+    s.unpack(name_in);
+    s.unpack(name_out);
+    s.unpack(sp_in);
+    s.unpack(sp_out);
+    casadi_assert_message(name_in.size()==sp_in.size() && name_out.size()==sp_out.size(),
+                          "Deserializer: Corrupt data");
+
+    // Symbolic primitives
+    vector<SX> arg(sp_in.size());
+    for (int i=0; i<arg.size(); ++i) {
+      vector<string> names;
+      s.unpack(names);
+      casadi_assert_message(names.size()==sp_in[i].nnz(), "Deserializer: Corrupt data");
+      arg[i] = SX::zeros(sp_in[i]);
+      for (int k=0; k<names.size(); ++k) arg[i].nonzeros()[k] = SXElem::sym(names[k]);
+    }
+    vector<string> free_names;
+    s.unpack(free_names);
+    vector<double> default_in;
+    s.unpack(default_in);
+
+    // Algorithm
+    int sz_w, n_alg;
+    s.unpack(sz_w);
+    s.unpack(n_alg);
+    casadi_assert_message(sz_w>=0 && n_alg>=0, "Deserializer: Corrupt data");
+    vector<AlgEl> algorithm(n_alg);
+    s.read(get_ptr(algorithm), algorithm.size()*sizeof(AlgEl));
+
+    // Rebuild the expression graph by replaying the algorithm symbolically,
+    // without simplifications so that the graph is reproduced exactly
+    vector<SX> res(sp_out.size());
+    for (int i=0; i<res.size(); ++i) res[i] = SX::zeros(sp_out[i]);
+    vector<SXElem> w(sz_w);
+    int p_ind = 0;
+    for (auto&& e : algorithm) {
+      casadi_assert_message(e.i0>=0 && (e.op==OP_OUTPUT ? e.i0<res.size() : e.i0<sz_w),
+                            "Deserializer: Corrupt data");
+      switch (e.op) {
+      case OP_CONST:
+        w[e.i0] = e.d;
+        break;
+      case OP_INPUT:
+        casadi_assert_message(e.i1>=0 && e.i1<arg.size() && e.i2>=0 && e.i2<arg[e.i1].nnz(),
+                              "Deserializer: Corrupt data");
+        w[e.i0] = arg[e.i1].nonzeros()[e.i2];
+        break;
+      case OP_OUTPUT:
+        casadi_assert_message(e.i1>=0 && e.i1<sz_w && e.i2>=0 && e.i2<res[e.i0].nnz(),
+                              "Deserializer: Corrupt data");
+        res[e.i0].nonzeros()[e.i2] = w[e.i1];
+        break;
+      case OP_PARAMETER:
+        casadi_assert_message(p_ind<free_names.size(), "Deserializer: Corrupt data");
+        w[e.i0] = SXElem::sym(free_names[p_ind++]);
+        break;
+      default:
+        casadi_assert_message(e.op>=0 && e.op<NUM_BUILT_IN_OPS && e.i1>=0 && e.i1<sz_w
+                              && e.i2>=0 && e.i2<sz_w, "Deserializer: Corrupt data");
+        if (casadi_math<double>::ndeps(e.op)==2) {
+          w[e.i0] = BinarySX::create(e.op, w[e.i1], w[e.i2]);
+        } else {
+          w[e.i0] = UnarySX::create(e.op, w[e.i1]);
+        }
+      }
+    }
+
+    // Create function
+    Dict opts2 = opts;
+    if (opts2.find("default_in")==opts2.end()) opts2["default_in"] = default_in;
+    return Function(name, arg, res, name_in, name_out, opts2);
+  }
+
+  std::string SXFunction::structure_fingerprint() const {
+    stringstream ss;
+    Serializer s(ss);
+    s.pack(type_name());
+    s.pack(isp_);
+    s.pack(osp_);
+    vector<int> alg;
+    alg.reserve(4*algorithm_.size());
+    for (auto&& e : algorithm_) {
+      alg.push_back(e.op);
+      alg.push_back(e.i0);
+      // The value of a constant does not affect the structure
+      alg.push_back(e.op==OP_CONST ? 0 : e.i1);
+      alg.push_back(e.op==OP_CONST ? 0 : e.i2);
+    }
+    s.pack(alg);
+    return ss.str();
+  }
+
+  Dict SXFunction::get_stats(void* mem) const {
+    Dict stats;
+    stats["n_cse"] = n_cse_;
+#ifdef WITH_OPCOUNT
+    stats["opcount"] = opcount_stats();
+#endif // WITH_OPCOUNT
+    return stats;
+  }
+
   std::string SXFunction::type_name() const {
     return "sxfunction";
   }
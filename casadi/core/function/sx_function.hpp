@@ -38,6 +38,9 @@
 /// \cond INTERNAL
 
 namespace casadi {
+  // Forward declaration
+  class NativeJit;
+
   /** \brief  An atomic operation for the SXElem virtual machine */
   struct ScalarAtomic {
     int op;     /// Operator index
@@ -97,6 +100,19 @@ class CASADI_EXPORT SXFunction :
   /** \brief  Evaluate numerically, work vectors given */
   virtual void eval(void* mem, const double** arg, double** res, int* iw, double* w) const;
 
+  /** \brief Number of instances processed simultaneously by eval_batch */
+  static const int batch_size = 8;
+
+  /** \brief Evaluate \a n instances with a single pass through the algorithm
+   *
+   * Input j of instance k is found at arg[j] + k*nnz_in(j) and similarly for the
+   * outputs, i.e. the storage format of a horizontally repeated (mapped) function.
+   * The work vector is stored structure-of-arrays with batch_size lanes per entry,
+   * so that each operation in the algorithm becomes a short vectorizable loop.
+   * Requires sz_w()*batch_size entries in \a w.
+   */
+  void eval_batch(const double** arg, double** res, int* iw, double* w, int n) const;
+
   /** \brief  evaluate symbolically while also propagating directional derivatives */
   virtual void eval_sx(const SXElem** arg, SXElem** res, int* iw, SXElem* w, int mem);
 
@@ -166,9 +182,12 @@ class CASADI_EXPORT SXFunction :
     stream << free_vars_;
   }
 
-  /** \brief Hessian (forward over adjoint) via source code transformation */
+  /** \brief Hessian via edge pushing or forward over adjoint source code transformation */
   SX hess(int iind=0, int oind=0);
 
+  /** \brief Hessian via edge pushing, returns false if not supported by the algorithm */
+  bool hess_edge_pushing(int iind, int oind, SX& H) const;
+
   /** \brief Get the number of atomic operations */
   virtual int getAlgorithmSize() const { return algorithm_.size();}
 
@@ -222,6 +241,9 @@ class CASADI_EXPORT SXFunction :
   /// Default input values
   std::vector<double> default_in_;
 
+  /// Number of nodes removed by common subexpression elimination
+  int n_cse_;
+
   ///@{
   /** \brief Options */
   static Options options_;
@@ -243,18 +265,56 @@ class CASADI_EXPORT SXFunction :
   /** \brief  Propagate sparsity backwards */
   virtual void sp_rev(bvec_t** arg, bvec_t** res, int* iw, bvec_t* w, int mem);
 
+  /** \brief  Can sparsity propagations run concurrently? */
+  virtual bool has_parallel_sp() const { return true;}
+
+  /** \brief Can several sets of bvec_size directions be propagated in a single pass? */
+  virtual bool has_sp_wide() const { return true;}
+
+  ///@{
+  /** \brief Propagate \a nw sets of directions at once */
+  virtual void sp_fwd_wide(const bvec_t** arg, bvec_t** res, int* iw, bvec_t* w, int nw);
+  virtual void sp_rev_wide(bvec_t** arg, bvec_t** res, int* iw, bvec_t* w, int nw);
+  ///@}
+
+  ///@{
+  /** \brief Wide sparsity propagation, NW words per nonzero (or \a nw if NW is 0) */
+  template<int NW>
+  void sp_fwd_wide_gen(const bvec_t** arg, bvec_t** res, bvec_t* w, int nw) const;
+  template<int NW>
+  void sp_rev_wide_gen(bvec_t** arg, bvec_t** res, bvec_t* w, int nw) const;
+  ///@}
+
   /** \brief Return Jacobian of all input elements with respect to all output elements */
   virtual Function getFullJacobian();
 
   /** \brief Get default input value */
   virtual double default_in(int ind) const { return default_in_.at(ind);}
 
+  /** \brief Get all statistics */
+  virtual Dict get_stats(void* mem) const;
+
+  /** \brief Serialize the algorithm, cf. Function::save */
+  virtual void serialize(Serializer& s) const;
+
+  /** \brief Create a function from serialized data */
+  static Function deserialize(Deserializer& s, const Dict& opts);
+
+  /** \brief Description of the algorithm and sparsity patterns */
+  virtual std::string structure_fingerprint() const;
+
   /// With just-in-time compilation using OpenCL
   bool just_in_time_opencl_;
 
   /// With just-in-time compilation for the sparsity propagation
   bool just_in_time_sparsity_;
 
+  /// With just-in-time compilation to native machine code
+  bool just_in_time_native_;
+
+  /// Native machine code for the numeric evaluation (null if not generated)
+  NativeJit* native_jit_;
+
 #ifdef WITH_OPENCL
   // Initialize sparsity propagation using OpenCL
   void allocOpenCL();
@@ -34,10 +34,69 @@
 #include <unordered_map>
 #define SPARSITY_MAP std::unordered_map
 
+#ifdef WITH_OPCOUNT
+#include <chrono>
+#include <mutex>
+#endif // WITH_OPCOUNT
+
 /// \cond INTERNAL
 
 namespace casadi {
 
+#ifdef WITH_OPCOUNT
+  /** \brief Number of executions and accumulated wall time per operation code
+   *
+   * Collected by the SX and MX virtual machines when compiled with WITH_OPCOUNT
+   */
+  struct OpCount {
+    std::vector<long> n;
+    std::vector<double> t;
+    OpCount() : n(NUM_BUILT_IN_OPS, 0), t(NUM_BUILT_IN_OPS, 0) {}
+
+    /// Add the counters of another instance
+    void add(const OpCount& c) {
+      for (int op=0; op<NUM_BUILT_IN_OPS; ++op) {
+        n[op] += c.n[op];
+        t[op] += c.t[op];
+      }
+    }
+
+    /// Table with the number of executions and time [s], per operation name
+    Dict stats() const {
+      // Operations can share a name, e.g. OP_POW and OP_CONSTPOW
+      std::map<std::string, std::pair<long, double> > acc;
+      for (int op=0; op<NUM_BUILT_IN_OPS; ++op) {
+        if (n[op]==0) continue;
+        std::pair<long, double>& a = acc[casadi_math<double>::name(op)];
+        a.first += n[op];
+        a.second += t[op];
+      }
+      Dict ret;
+      for (auto&& a : acc) {
+        ret[a.first] = Dict{{"n_call", static_cast<int>(a.second.first)},
+                            {"t_wall", a.second.second}};
+      }
+      return ret;
+    }
+  };
+
+  /** \brief Time the execution of one operation, for the lifetime of the object */
+  class OpCountTimer {
+  public:
+    OpCountTimer(OpCount& c, int op) : c_(c), op_(op),
+                                        start_(std::chrono::steady_clock::now()) {}
+    ~OpCountTimer() {
+      c_.n[op_]++;
+      c_.t[op_] += std::chrono::duration<double>(std::chrono::steady_clock::now()
+                                                 - start_).count();
+    }
+  private:
+    OpCount& c_;
+    int op_;
+    std::chrono::steady_clock::time_point start_;
+  };
+#endif // WITH_OPCOUNT
+
   /** \brief  Internal node class for the base class of SXFunction and MXFunction
       (lacks a public counterpart)
       The design of the class uses the curiously recurring template pattern (CRTP) idiom
@@ -188,6 +247,23 @@ namespace casadi {
 
     /** \brief  Outputs of the function (needed for symbolic calculations) */
     std::vector<MatType> out_;
+
+#ifdef WITH_OPCOUNT
+    /// Add the execution counters of one numerical evaluation
+    void opcount_add(const OpCount& c) const {
+      std::lock_guard<std::mutex> lock(opcount_mtx_);
+      opcount_.add(c);
+    }
+
+    /// Execution counters, accumulated over all numerical evaluations
+    Dict opcount_stats() const {
+      std::lock_guard<std::mutex> lock(opcount_mtx_);
+      return opcount_.stats();
+    }
+
+    mutable OpCount opcount_;
+    mutable std::mutex opcount_mtx_;
+#endif // WITH_OPCOUNT
   };
 
   // Template implementations
@@ -680,6 +756,10 @@ namespace casadi {
     int nfdir = D1.is_null() ? 0 : D1.size2();
     int nadir = D2.is_null() ? 0 : D2.size2();
 
+    // With an acyclic coloring, the entries are recovered by substitution after all sweeps
+    bool acyclic = symmetric && hessian_coloring_=="acyclic";
+    std::vector<MatType> bcol(acyclic ? nfdir : 0);
+
     // Number of derivative directions supported by the function
     int max_nfdir = max_num_dir_;
     int max_nadir = max_num_dir_;
@@ -838,17 +918,22 @@ namespace casadi {
       // Evaluate symbolically
       if (verbose()) userOut() << "XFunction::jac making function call" << std::endl;
       if (fseed.size()>0) {
-        casadi_assert(aseed.size()==0);
         forward(in_, out_, fseed, fsens, always_inline, never_inline);
-      } else if (aseed.size()>0) {
-        casadi_assert(fseed.size()==0);
+      }
+      if (aseed.size()>0) {
         reverse(in_, out_, aseed, asens, always_inline, never_inline);
       }
 
       // Carry out the forward sweeps
       for (int d=0; d<nfdir_batch; ++d) {
 
-        // If symmetric, see how many times each output appears
+        // Save the compressed Hessian column
+        if (acyclic) {
+          bcol[offset_nfdir+d] = fsens[d][oind];
+          continue;
+        }
+
+        // If symmetric or bidirectional, see how many times each output appears
         if (symmetric) {
           // Initialize to zero
           tmp.resize(nnz_out(oind));
@@ -865,6 +950,18 @@ namespace casadi {
               tmp[jsp_row[el_jsp]]++;
             }
           }
+        } else if (nadir>0) {
+          // Initialize to zero
+          tmp.resize(nnz_out(oind));
+          fill(tmp.begin(), tmp.end(), 0);
+
+          // Outputs seen by the inputs of the direction
+          for (int el = D1.colind(offset_nfdir+d); el<D1.colind(offset_nfdir+d+1); ++el) {
+            int c = D1.row(el);
+            for (int el_out = jsp_trans.colind(c); el_out<jsp_trans.colind(c+1); ++el_out) {
+              tmp[jsp_trans.row(el_out)]++;
+            }
+          }
         }
 
         // Locate the nonzeros of the forward sensitivity matrix
@@ -912,8 +1009,8 @@ namespace casadi {
                 adds[f_out] = el_out;
                 adds2[f_out] = elJ;
               }
-            } else {
-              // Get the output seed
+            } else if (nadir==0 || tmp[r_out]==1) {
+              // Get the output seed, unless other inputs contribute (left to the adjoint mode)
               adds[f_out] = elJ;
             }
           }
@@ -959,6 +1056,16 @@ namespace casadi {
         sparsity_in(iind).find(nzmap);
         asens[d][iind].sparsity().get_nz(nzmap);
 
+        // If bidirectional, see how many times each input appears
+        if (nfdir>0) {
+          tmp.resize(nnz_in(iind));
+          fill(tmp.begin(), tmp.end(), 0);
+          for (int el = D2.colind(offset_nadir+d); el<D2.colind(offset_nadir+d+1); ++el) {
+            int r = D2.row(el);
+            for (int elJ = jsp.colind(r); elJ<jsp.colind(r+1); ++elJ) tmp[jsp.row(elJ)]++;
+          }
+        }
+
         // For all the output nonzeros treated in the sweep
         for (int el = D2.colind(offset_nadir+d); el<D2.colind(offset_nadir+d+1); ++el) {
 
@@ -975,6 +1082,9 @@ namespace casadi {
             int anz = nzmap[inz];
             if (anz<0) continue;
 
+            // Skip if other outputs contribute (left to the forward mode)
+            if (nfdir>0 && tmp[inz]!=1) continue;
+
             // Get the input seed
             ret.nz(elJ) = asens[d][iind].nz(anz);
           }
@@ -986,6 +1096,89 @@ namespace casadi {
       offset_nadir += nadir_batch;
     }
 
+    // Recover the Hessian from its compressed columns
+    if (acyclic) {
+      if (verbose()) userOut() << "XFunction::jac recovery by substitution" << std::endl;
+
+      // Color of each vertex
+      std::vector<int> color(jsp.size2());
+      for (int c=0; c<nfdir; ++c) {
+        for (int el=D1.colind(c); el<D1.colind(c+1); ++el) color[D1.row(el)] = c;
+      }
+
+      // Entries of the compressed Hessian, b[c][i] being row i of column c
+      std::vector<std::vector<MatType> > b(nfdir);
+      std::vector<std::vector<int> > bnz(nfdir);
+      for (int c=0; c<nfdir; ++c) {
+        const MatType& bc = bcol[c];
+        b[c] = vertsplit(bc.nz(Slice()), 1);
+        sparsity_out(oind).find(bnz[c]);
+        bcol[c].sparsity().get_nz(bnz[c]);
+      }
+
+      // Group the off-diagonal nonzeros of each column by the color of the row
+      std::vector<int> group(jsp.nnz(), -1), group_col, group_color, group_count;
+      std::vector<int> color_group(nfdir, -1);
+      for (int i=0; i<jsp.size2(); ++i) {
+        for (int k=jsp_colind[i]; k<jsp_colind[i+1]; ++k) {
+          int c = color[jsp_row[k]];
+          if (jsp_row[k]==i) continue;
+          int g = color_group[c];
+          if (g<0 || group_col[g]!=i) {
+            g = color_group[c] = group_col.size();
+            group_col.push_back(i);
+            group_color.push_back(c);
+            group_count.push_back(0);
+          }
+          group[k] = g;
+          group_count[g]++;
+        }
+      }
+
+      // Recovered entries and, per group, the sum of those recovered so far
+      std::vector<MatType> hv(jsp.nnz());
+      std::vector<MatType> group_sum(group_col.size(), 0);
+      std::vector<bool> recovered(jsp.nnz(), false);
+
+      // Diagonal entries are found directly
+      for (int i=0; i<jsp.size2(); ++i) {
+        for (int k=jsp_colind[i]; k<jsp_colind[i+1]; ++k) {
+          if (jsp_row[k]!=i) continue;
+          int bk = bnz[color[i]][i];
+          hv[k] = bk<0 ? MatType(0) : b[color[i]][bk];
+          recovered[k] = true;
+        }
+      }
+
+      // The two-colored subgraphs are forests: peel off the leaves
+      std::vector<int> leaves;
+      for (int g=0; g<group_count.size(); ++g) if (group_count[g]==1) leaves.push_back(g);
+      while (!leaves.empty()) {
+        int g = leaves.back();
+        leaves.pop_back();
+        if (group_count[g]!=1) continue;
+
+        // The only entry of the group not yet recovered
+        int i = group_col[g], k;
+        for (k=jsp_colind[i]; k<jsp_colind[i+1]; ++k) {
+          if (group[k]==g && !recovered[k]) break;
+        }
+
+        // Compressed entry minus the entries already known
+        int bk = bnz[group_color[g]][i];
+        MatType h = (bk<0 ? MatType(0) : b[group_color[g]][bk]) - group_sum[g];
+        int k2 = mapping[k], g2 = group[k2];
+        hv[k] = hv[k2] = h;
+        recovered[k] = recovered[k2] = true;
+        group_count[g]--;
+        group_sum[g2] += h;
+        if (--group_count[g2]==1) leaves.push_back(g2);
+      }
+      casadi_assert_message(std::find(recovered.begin(), recovered.end(), false)
+                            == recovered.end(), "Hessian recovery failed: coloring not acyclic");
+      ret = MatType(ret.sparsity(), vertcat(hv));
+    }
+
     // Return
     if (verbose()) userOut() << "XFunction::jac end" << std::endl;
     return ret.T();
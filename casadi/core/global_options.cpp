@@ -30,6 +30,9 @@ namespace casadi {
 
   bool GlobalOptions::simplification_on_the_fly = true;
   bool GlobalOptions::hierarchical_sparsity = true;
+  int GlobalOptions::sparsity_threads = 1;
+  int GlobalOptions::sparsity_width = 8;
+  std::string GlobalOptions::sparsity_cache = "";
 
   std::string GlobalOptions::casadipath = "";
 
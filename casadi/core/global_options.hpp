@@ -61,6 +61,26 @@ namespace casadi {
 
       static bool hierarchical_sparsity;
 
+      /** \brief Number of threads used for Jacobian sparsity pattern detection
+      * 0 means the number of hardware threads, 1 disables multithreading.
+      * Functions too small to benefit use fewer threads.
+      * Default: 1
+      */
+      static int sparsity_threads;
+
+      /** \brief Number of bvec_t words per nonzero in sparsity propagation
+      * Functions supporting wide propagation process this many sets of directions in
+      * a single pass through their algorithm.
+      * Default: 8
+      */
+      static int sparsity_width;
+
+      /** \brief Directory for caching Jacobian sparsity patterns and colorings on disk
+      * Entries are keyed by the structure of the function. Empty disables the cache.
+      * Default: ""
+      */
+      static std::string sparsity_cache;
+
 #endif //SWIG
       // Setter and getter for simplification_on_the_fly
       static void setSimplificationOnTheFly(bool flag) { simplification_on_the_fly = flag; }
@@ -70,6 +90,18 @@ namespace casadi {
       static void setHierarchicalSparsity(bool flag) { hierarchical_sparsity = flag; }
       static bool getHierarchicalSparsity() { return hierarchical_sparsity; }
 
+      // Setter and getter for sparsity_threads
+      static void setSparsityThreads(int n) { sparsity_threads = n; }
+      static int getSparsityThreads() { return sparsity_threads; }
+
+      // Setter and getter for sparsity_width
+      static void setSparsityWidth(int n) { sparsity_width = n; }
+      static int getSparsityWidth() { return sparsity_width; }
+
+      // Setter and getter for sparsity_cache
+      static void setSparsityCache(const std::string& dir) { sparsity_cache = dir; }
+      static std::string getSparsityCache() { return sparsity_cache; }
+
       static void setCasadiPath(const std::string & path) { casadipath = path; }
       static std::string getCasadiPath() { return casadipath; }
 
@@ -135,6 +135,10 @@ namespace casadi {
     }
   }
 
+  int Call::checkout() const {
+    return fcn_->checkout(true);
+  }
+
   void Call::sp_fwd(const bvec_t** arg, bvec_t** res, int* iw, bvec_t* w, int mem) {
     fcn_(arg, res, iw, w, mem);
   }
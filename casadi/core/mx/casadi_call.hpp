@@ -90,6 +90,12 @@ namespace casadi {
     /// Evaluate the function numerically
     virtual void eval(const double** arg, double** res, int* iw, double* w, int mem) const;
 
+    /// Checkout a memory object of the called function
+    virtual int checkout() const;
+
+    /// Release a memory object of the called function
+    virtual void release(int mem) const { fcn_.release(mem);}
+
     /// Evaluate the function symbolically (SX)
     virtual void eval_sx(const SXElem** arg, SXElem** res, int* iw, SXElem* w, int mem);
 
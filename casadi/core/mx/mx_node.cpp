@@ -297,6 +297,13 @@ namespace casadi {
                           typeid(*this).name());
   }
 
+  bool MXNode::has_parallel_sp() const {
+    for (int i=0; i<numFunctions(); ++i) {
+      if (!getFunction(i)->has_parallel_sp()) return false;
+    }
+    return true;
+  }
+
   int MXNode::getFunctionOutput() const {
     throw CasadiException(string("MXNode::getFunctionOutput() not defined for class ") +
                           typeid(*this).name());
@@ -312,6 +319,19 @@ namespace casadi {
                           + typeid(*this).name());
   }
 
+  void MXNode::eval_batch(const double** arg, double** res, int* iw, double* w,
+                          int n, int stride, int mem) const {
+    // Pointers of the first instance, arg and res are then reused for each instance
+    // since the entries beyond ndep() and nout() may be needed by a called function
+    vector<const double*> arg0(arg, arg+ndep());
+    vector<double*> res0(res, res+nout());
+    for (int k=0; k<n; ++k) {
+      for (int i=0; i<arg0.size(); ++i) arg[i] = arg0[i] ? arg0[i] + k*stride : 0;
+      for (int i=0; i<res0.size(); ++i) res[i] = res0[i] ? res0[i] + k*stride : 0;
+      eval(arg, res, iw, w + k*stride, mem);
+    }
+  }
+
   void MXNode::eval_sx(const SXElem** arg, SXElem** res, int* iw, SXElem* w, int mem) {
     throw CasadiException(string("MXNode::eval_sx not defined for class ")
                           + typeid(*this).name());
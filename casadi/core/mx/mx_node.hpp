@@ -31,6 +31,7 @@
 #include "../calculus.hpp"
 #include "../function/code_generator.hpp"
 #include "../function/linsol.hpp"
+#include "../node_pool.hpp"
 #include <vector>
 #include <stack>
 
@@ -86,6 +87,12 @@ namespace casadi {
     /** \brief  Destructor */
     virtual ~MXNode()=0;
 
+    ///@{
+    /** \brief  Nodes are allocated from a pool */
+    static void* operator new(size_t sz) { return NodePool::allocate(sz);}
+    static void operator delete(void* p, size_t sz) { NodePool::deallocate(p, sz);}
+    ///@}
+
     /** \brief Check the truth value of this node
      */
     virtual bool __nonzero__() const;
@@ -143,6 +150,29 @@ namespace casadi {
     /** \brief  Evaluate numerically */
     virtual void eval(const double** arg, double** res, int* iw, double* w, int mem) const;
 
+    /** \brief Evaluate \a n instances numerically
+
+        The arguments, results and work vector of instance k are offset by k*stride
+        from those of the first instance. By default, the instances are evaluated
+        one at a time.
+    */
+    virtual void eval_batch(const double** arg, double** res, int* iw, double* w,
+                            int n, int stride, int mem) const;
+
+    /** \brief Does eval_batch do better than evaluating the instances one at a time */
+    virtual bool has_eval_batch() const { return false;}
+
+    /** \brief Checkout a memory object for numerical evaluation
+
+        Called for each memory object of a function containing the node, so that
+        concurrent evaluations of the function do not share the state of the node.
+        Memory object 0 of an embedded function is left for its direct calls.
+    */
+    virtual int checkout() const { return 0;}
+
+    /// Release a memory object
+    virtual void release(int mem) const {}
+
     /** \brief  Evaluate symbolically (SX) */
     virtual void eval_sx(const SXElem** arg, SXElem** res, int* iw, SXElem* w, int mem);
 
@@ -202,6 +232,13 @@ namespace casadi {
     /** \brief  Get function reference */
     virtual const Function& getFunction(int i) const;
 
+    /** \brief Can seeds be propagated from several threads concurrently?
+     *
+     * As for FunctionInternal::has_parallel_sp, the first propagation may initialize
+     * cached data. By default true if it holds for all embedded functions.
+     */
+    virtual bool has_parallel_sp() const;
+
     /** \brief  Get function input */
     virtual int getFunction_input() const;
 
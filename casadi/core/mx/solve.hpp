@@ -58,6 +58,19 @@ namespace casadi {
     /// Evaluate the function numerically
     virtual void eval(const double** arg, double** res, int* iw, double* w, int mem) const;
 
+    /// Evaluate \a n instances numerically, solving the linear systems as a batch
+    virtual void eval_batch(const double** arg, double** res, int* iw, double* w,
+                            int n, int stride, int mem) const;
+
+    /// Does eval_batch do better than evaluating the instances one at a time
+    virtual bool has_eval_batch() const { return true;}
+
+    /// Checkout a memory object of the linear solver
+    virtual int checkout() const;
+
+    /// Release a memory object of the linear solver
+    virtual void release(int mem) const { linsol_.release(mem);}
+
     /// Evaluate the function symbolically (SX)
     virtual void eval_sx(const SXElem** arg, SXElem** res, int* iw, SXElem* w, int mem);
 
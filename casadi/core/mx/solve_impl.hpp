@@ -53,10 +53,27 @@ namespace casadi {
   template<bool Tr>
   void Solve<Tr>::eval(const double** arg, double** res, int* iw, double* w, int mem) const {
     if (arg[0]!=res[0]) copy(arg[0], arg[0]+dep(0).nnz(), res[0]);
-    linsol_.reset(dep(1).sparsity());
-    linsol_.pivoting(arg[1]);
-    linsol_.factorize(arg[1]);
-    linsol_.solve(res[0], dep(0).size2(), Tr);
+    linsol_.reset(dep(1).sparsity(), mem);
+    linsol_.pivoting(arg[1], mem);
+    linsol_.factorize(arg[1], mem);
+    linsol_.solve(res[0], dep(0).size2(), Tr, mem);
+  }
+
+  template<bool Tr>
+  void Solve<Tr>::eval_batch(const double** arg, double** res, int* iw, double* w,
+                             int n, int stride, int mem) const {
+    if (arg[0]!=res[0]) {
+      for (int k=0; k<n; ++k) {
+        copy(arg[0] + k*stride, arg[0] + k*stride + dep(0).nnz(), res[0] + k*stride);
+      }
+    }
+    linsol_.reset(dep(1).sparsity(), mem);
+    linsol_.solve_batch(arg[1], stride, res[0], stride, n, dep(0).size2(), Tr, mem);
+  }
+
+  template<bool Tr>
+  int Solve<Tr>::checkout() const {
+    return linsol_->checkout(true);
   }
 
   template<bool Tr>
@@ -0,0 +1,216 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+
+#include "node_pool.hpp"
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <vector>
+#include <algorithm>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif // _WIN32
+
+using namespace std;
+
+namespace casadi {
+
+  // Number of size classes
+  static const size_t n_classes = NodePool::max_size/NodePool::granularity;
+
+  // Free-list entry, placed in the memory of a free object
+  struct NodePoolEntry {
+    NodePoolEntry* next;
+  };
+
+  // Free lists and statistics of one thread
+  struct NodePoolCache {
+    // Free lists, one per size class
+    NodePoolEntry* free[n_classes];
+
+    // Objects allocated minus objects freed by this thread, only written by the owner
+    atomic<long> n_allocated;
+
+    NodePoolCache() : n_allocated(0) {
+      for (auto&& f : free) f = 0;
+    }
+
+    // Update the allocation counter, only called by the owner
+    void count(long n) {
+      n_allocated.store(n_allocated.load(memory_order_relaxed) + n, memory_order_relaxed);
+    }
+  };
+
+  // State shared between the threads
+  struct NodePoolDepot {
+    // Lock for all members except n_reserved
+    mutex mtx;
+
+    // Free lists of exited threads, also used by threads without a cache
+    NodePoolCache shared;
+
+    // Caches of the running threads
+    vector<NodePoolCache*> caches;
+
+    // Bytes reserved from the system
+    atomic<size_t> n_reserved;
+
+    NodePoolDepot();
+  };
+
+  // Shared state, intentionally never destroyed since static nodes may be
+  // released during static destruction
+  static NodePoolDepot& depot() {
+    static NodePoolDepot* d = new NodePoolDepot();
+    return *d;
+  }
+
+  // Hold the lock while forking, so that a child process does not inherit it locked
+  static void depot_lock() { depot().mtx.lock();}
+  static void depot_unlock() { depot().mtx.unlock();}
+
+  NodePoolDepot::NodePoolDepot() : n_reserved(0) {
+#ifndef _WIN32
+    pthread_atfork(depot_lock, depot_unlock, depot_unlock);
+#endif // _WIN32
+  }
+
+  // Cache of the current thread, null if not created or already destroyed
+  static thread_local NodePoolCache* thread_cache = 0;
+
+  // Has the cache of the current thread been destroyed
+  static thread_local bool thread_exited = false;
+
+  // Owner of the cache of a thread, hands over the free lists when the thread exits
+  struct NodePoolCacheOwner {
+    NodePoolCache cache;
+    NodePoolCacheOwner() {
+      NodePoolDepot& d = depot();
+      lock_guard<mutex> lock(d.mtx);
+      d.caches.push_back(&cache);
+    }
+    ~NodePoolCacheOwner() {
+      NodePoolDepot& d = depot();
+      lock_guard<mutex> lock(d.mtx);
+      for (size_t c=0; c<n_classes; ++c) {
+        NodePoolEntry* e = cache.free[c];
+        if (e==0) continue;
+        while (e->next) e = e->next;
+        e->next = d.shared.free[c];
+        d.shared.free[c] = cache.free[c];
+      }
+      d.shared.count(cache.n_allocated.load(memory_order_relaxed));
+      d.caches.erase(find(d.caches.begin(), d.caches.end(), &cache));
+      thread_cache = 0;
+      thread_exited = true;
+    }
+  };
+
+  // Get the cache of the current thread, null during thread exit
+  static NodePoolCache* get_cache() {
+    if (thread_cache) return thread_cache;
+    if (thread_exited) return 0;
+    static thread_local NodePoolCacheOwner owner;
+    thread_cache = &owner.cache;
+    return thread_cache;
+  }
+
+  // Allocate a new slab for size class c and thread it onto a free list
+  static void new_slab(NodePoolEntry*& free, size_t c) {
+    size_t obj_sz = (c+1)*NodePool::granularity;
+    char* slab = static_cast<char*>(::operator new(obj_sz*NodePool::slab_size));
+    depot().n_reserved += obj_sz*NodePool::slab_size;
+    for (size_t i=NodePool::slab_size; i-->0; ) {
+      NodePoolEntry* e = reinterpret_cast<NodePoolEntry*>(slab + i*obj_sz);
+      e->next = free;
+      free = e;
+    }
+  }
+
+  // Pop an object from a free list, refilling it if empty
+  static void* pop(NodePoolCache& cache, size_t c) {
+    if (cache.free[c]==0) new_slab(cache.free[c], c);
+    NodePoolEntry* e = cache.free[c];
+    cache.free[c] = e->next;
+    cache.count(1);
+    return e;
+  }
+
+  void* NodePool::allocate(size_t sz) {
+    if (sz>max_size || sz==0) return ::operator new(sz);
+    size_t c = (sz-1)/granularity;
+    NodePoolCache* cache = get_cache();
+    if (cache) {
+      // Take over the objects of exited threads before allocating a new slab
+      if (cache->free[c]==0) {
+        NodePoolDepot& d = depot();
+        lock_guard<mutex> lock(d.mtx);
+        cache->free[c] = d.shared.free[c];
+        d.shared.free[c] = 0;
+      }
+      return pop(*cache, c);
+    } else {
+      NodePoolDepot& d = depot();
+      lock_guard<mutex> lock(d.mtx);
+      return pop(d.shared, c);
+    }
+  }
+
+  void NodePool::deallocate(void* p, size_t sz) {
+    if (p==0) return;
+    if (sz>max_size || sz==0) return ::operator delete(p);
+    size_t c = (sz-1)/granularity;
+    NodePoolEntry* e = static_cast<NodePoolEntry*>(p);
+    // Objects freed by another thread than the allocating one join the free list
+    // of the freeing thread, slabs are never returned to the system
+    NodePoolCache* cache = get_cache();
+    if (cache) {
+      e->next = cache->free[c];
+      cache->free[c] = e;
+      cache->count(-1);
+    } else {
+      NodePoolDepot& d = depot();
+      lock_guard<mutex> lock(d.mtx);
+      e->next = d.shared.free[c];
+      d.shared.free[c] = e;
+      d.shared.count(-1);
+    }
+  }
+
+  size_t NodePool::n_allocated() {
+    NodePoolDepot& d = depot();
+    lock_guard<mutex> lock(d.mtx);
+    long ret = d.shared.n_allocated.load(memory_order_relaxed);
+    for (NodePoolCache* c : d.caches) ret += c->n_allocated.load(memory_order_relaxed);
+    return ret;
+  }
+
+  size_t NodePool::n_reserved() {
+    return depot().n_reserved;
+  }
+
+} // namespace casadi
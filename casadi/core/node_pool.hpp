@@ -0,0 +1,77 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifndef CASADI_NODE_POOL_HPP
+#define CASADI_NODE_POOL_HPP
+
+#include "casadi_common.hpp"
+#include <cstddef>
+
+namespace casadi {
+  /// \cond INTERNAL
+
+  /** \brief Slab allocator for expression graph nodes
+
+      Small objects are grouped into size classes. Each size class takes memory from
+      the system in large slabs and recycles freed objects through a free list,
+      avoiding the per-allocation overhead and heap fragmentation of individual
+      new/delete calls. Slab memory is kept for reuse and never returned to the system.
+      Larger objects are forwarded to the global operator new.
+
+      Each thread allocates from and frees to its own free lists, without locking.
+      Objects freed by another thread than the allocating one join the free lists of
+      the freeing thread. When a thread exits, its free lists are handed over to a
+      shared, locked depot, from which other threads refill before taking a new slab.
+      Note that the reference counting of the nodes, including that of the shared
+      constant nodes, is not synchronized.
+  */
+  class CASADI_EXPORT NodePool {
+  public:
+    /// Allocate memory for an object of size \a sz
+    static void* allocate(size_t sz);
+
+    /// Free memory allocated with allocate, \a sz must match
+    static void deallocate(void* p, size_t sz);
+
+    /// Number of objects currently allocated from the pool
+    static size_t n_allocated();
+
+    /// Number of bytes reserved from the system
+    static size_t n_reserved();
+
+    /// Granularity of the size classes
+    static const size_t granularity = 16;
+
+    /// Largest object size handled by the pool
+    static const size_t max_size = 256;
+
+    /// Number of objects per slab
+    static const size_t slab_size = 4096;
+  };
+
+  /// \endcond
+} // namespace casadi
+
+#endif // CASADI_NODE_POOL_HPP
@@ -0,0 +1,214 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "profiler.hpp"
+#include "exception.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <vector>
+
+using namespace std;
+
+namespace casadi {
+
+  std::atomic<bool> Profiler::active_(false);
+
+  // A completed event
+  struct ProfilerEvent {
+    string name;
+    const char* cat;
+    int instance, tid;
+    double t_begin, t_wall, t_wall_self, t_proc;
+  };
+
+  // An event in progress
+  struct ProfilerFrame {
+    const void* owner;
+    const string* name;
+    const char* cat;
+    double t_begin, t_proc_begin, t_child;
+  };
+
+  // Recorded events, shared by all threads
+  struct ProfilerData {
+    mutex mtx;
+    vector<ProfilerEvent> events;
+    map<const void*, int> instances;
+    chrono::steady_clock::time_point origin;
+    int n_threads;
+    ProfilerData() : origin(chrono::steady_clock::now()), n_threads(0) {}
+  };
+
+  static ProfilerData& profiler_data() {
+    static ProfilerData data;
+    return data;
+  }
+
+  // Events in progress, per thread
+  static thread_local vector<ProfilerFrame> profiler_stack;
+
+  // Thread index in the trace, assigned at the first event
+  static thread_local int profiler_tid = -1;
+
+  // Wall time since the start of the recording [s]
+  static double profiler_wall() {
+    return chrono::duration<double>(chrono::steady_clock::now()
+                                    - profiler_data().origin).count();
+  }
+
+  // CPU time of the calling thread [s]
+  static double profiler_proc() {
+#ifdef CLOCK_THREAD_CPUTIME_ID
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + 1e-9*ts.tv_nsec;
+#else // CLOCK_THREAD_CPUTIME_ID
+    return clock() / static_cast<double>(CLOCKS_PER_SEC);
+#endif // CLOCK_THREAD_CPUTIME_ID
+  }
+
+  // Write a string literal in JSON
+  static void profiler_quote(ostream& stream, const string& s) {
+    stream << '"';
+    for (char c : s) {
+      if (c=='"' || c=='\\') {
+        stream << '\\' << c;
+      } else if (static_cast<unsigned char>(c)<0x20) {
+        stream << ' ';
+      } else {
+        stream << c;
+      }
+    }
+    stream << '"';
+  }
+
+  void Profiler::start() {
+    ProfilerData& data = profiler_data();
+    lock_guard<mutex> lock(data.mtx);
+    data.events.clear();
+    data.instances.clear();
+    data.origin = chrono::steady_clock::now();
+    active_ = true;
+  }
+
+  void Profiler::stop() {
+    active_ = false;
+  }
+
+  bool Profiler::is_active() {
+    return active_;
+  }
+
+  Dict Profiler::stats() {
+    ProfilerData& data = profiler_data();
+    lock_guard<mutex> lock(data.mtx);
+
+    // Accumulate per instance, ordered by name and first call
+    struct Acc { int n_call; double t_wall, t_wall_self, t_proc;};
+    map<pair<string, int>, Acc> acc;
+    for (auto&& e : data.events) {
+      Acc& a = acc.insert(make_pair(make_pair(e.name, e.instance),
+                                    Acc{0, 0, 0, 0})).first->second;
+      a.n_call++;
+      a.t_wall += e.t_wall;
+      a.t_wall_self += e.t_wall_self;
+      a.t_proc += e.t_proc;
+    }
+
+    // Number of instances per name
+    map<string, int> n_instances;
+    for (auto&& a : acc) n_instances[a.first.first]++;
+
+    Dict ret;
+    map<string, int> k_instance;
+    for (auto&& a : acc) {
+      const string& name = a.first.first;
+      string key = name;
+      if (n_instances[name]>1) key += "#" + to_string(k_instance[name]++);
+      ret[key] = Dict{{"name", name}, {"n_call", a.second.n_call},
+                      {"t_wall", a.second.t_wall},
+                      {"t_wall_self", a.second.t_wall_self},
+                      {"t_proc", a.second.t_proc}};
+    }
+    return ret;
+  }
+
+  void Profiler::save(const std::string& fname) {
+    ofstream stream(fname.c_str());
+    casadi_assert_message(stream.good(), "Profiler::save: Cannot open \"" << fname << "\"");
+    save(stream);
+  }
+
+  void Profiler::save(std::ostream& stream) {
+    ProfilerData& data = profiler_data();
+    lock_guard<mutex> lock(data.mtx);
+
+    // Complete events ("ph":"X") with times in microseconds
+    stream << "{\"traceEvents\":[";
+    stream << setprecision(15);
+    for (int k=0; k<data.events.size(); ++k) {
+      const ProfilerEvent& e = data.events[k];
+      stream << (k==0 ? "\n" : ",\n") << "{\"name\":";
+      profiler_quote(stream, e.name);
+      stream << ",\"cat\":\"" << e.cat << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << e.tid
+             << ",\"ts\":" << 1e6*e.t_begin << ",\"dur\":" << 1e6*e.t_wall
+             << ",\"args\":{\"instance\":" << e.instance
+             << ",\"t_proc\":" << e.t_proc
+             << ",\"t_wall_self\":" << e.t_wall_self << "}}";
+    }
+    stream << "\n],\"displayTimeUnit\":\"ms\"}" << endl;
+  }
+
+  void ProfilerScope::begin(const void* owner, const std::string& name, const char* cat) {
+    profiler_stack.push_back(ProfilerFrame{owner, &name, cat, profiler_wall(), profiler_proc(), 0});
+  }
+
+  void ProfilerScope::end() {
+    ProfilerFrame f = profiler_stack.back();
+    profiler_stack.pop_back();
+
+    // Time spent in this event
+    double t_wall = profiler_wall() - f.t_begin;
+    double t_proc = profiler_proc() - f.t_proc_begin;
+
+    // Exclude from the self time of the enclosing event
+    if (!profiler_stack.empty()) profiler_stack.back().t_child += t_wall;
+
+    // Record
+    ProfilerData& data = profiler_data();
+    lock_guard<mutex> lock(data.mtx);
+    if (profiler_tid<0) profiler_tid = data.n_threads++;
+    int instance = data.instances.insert(make_pair(f.owner, data.instances.size())).first->second;
+    string name = strcmp(f.cat, "eval")==0 ? *f.name : *f.name + "." + f.cat;
+    data.events.push_back(ProfilerEvent{name, f.cat, instance, profiler_tid, f.t_begin, t_wall,
+                                        t_wall - f.t_child, t_proc});
+  }
+
+} // namespace casadi
@@ -0,0 +1,121 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef CASADI_PROFILER_HPP
+#define CASADI_PROFILER_HPP
+
+#include "generic_type.hpp"
+
+#ifndef SWIG
+#include <atomic>
+#endif // SWIG
+
+namespace casadi {
+
+  /**
+  * \brief Hierarchical profiling of function evaluations
+  *
+  * When active, every numerical evaluation of a Function, as well as the
+  * factorizations and solves of linear solvers, is recorded together with its
+  * nesting, so that e.g. the time an NLP solver spends in an integrator which
+  * in turn spends it in a rootfinder can be attributed. The recording can be
+  * exported in the Chrome trace event format, which can be viewed as a
+  * timeline or flame graph in chrome://tracing, Perfetto or speedscope.
+  *
+  * This class must never be instantiated. Access its static members directly.
+  * When not active, the overhead is a single flag check per evaluation.
+  */
+  class CASADI_EXPORT Profiler {
+    private:
+      /// No instances are allowed
+      Profiler();
+    public:
+      /// Discard any previous recording and start recording
+      static void start();
+
+      /// Stop recording, the recording is kept
+      static void stop();
+
+      /// Is recording active?
+      static bool is_active();
+
+      /** \brief Accumulated statistics, per function instance
+       *
+       * For each recorded function instance, a dictionary with its name (name),
+       * the number of calls (n_call), the wall time including (t_wall) and
+       * excluding (t_wall_self) nested calls, and the CPU time of the calling
+       * thread (t_proc). Entries are keyed by name, or by <name>#<k> if several
+       * instances share a name, numbered in the order they were first recorded.
+       * Linear solver factorizations and solves are recorded as
+       * <name>.factorize and <name>.solve.
+       */
+      static Dict stats();
+
+      /// Save the recording to a file in the Chrome trace event (JSON) format
+      static void save(const std::string& fname);
+
+#ifndef SWIG
+      /// Write the recording in the Chrome trace event (JSON) format
+      static void save(std::ostream& stream);
+
+      /// Is recording active, cf. is_active()
+      static std::atomic<bool> active_;
+#endif // SWIG
+  };
+
+#ifndef SWIG
+  /// \cond INTERNAL
+  /** \brief Records the lifetime of an object as an event in the Profiler
+   *
+   * Events are attributed to \a owner, e.g. the FunctionInternal instance,
+   * and labeled with \a name, which must outlive the object.
+   */
+  class CASADI_EXPORT ProfilerScope {
+  public:
+    /// Start event, if the profiler is active
+    ProfilerScope(const void* owner, const std::string& name, const char* cat)
+      : active_(Profiler::active_.load(std::memory_order_relaxed)) {
+      if (active_) begin(owner, name, cat);
+    }
+
+    /// End event
+    ~ProfilerScope() { if (active_) end();}
+
+  private:
+    // Copying not allowed
+    ProfilerScope(const ProfilerScope&);
+    ProfilerScope& operator=(const ProfilerScope&);
+
+    void begin(const void* owner, const std::string& name, const char* cat);
+    void end();
+
+    /// Was the profiler active when the event started
+    bool active_;
+  };
+  /// \endcond
+#endif // SWIG
+
+} // namespace casadi
+
+#endif // CASADI_PROFILER_HPP
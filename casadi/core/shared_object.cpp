@@ -64,6 +64,16 @@ namespace casadi {
     node = node_;
   }
 
+  bool SharedObject::assignNodeIfAlive(SharedObjectNode* node_) {
+    unsigned int c = node_->count.load();
+    do {
+      if (c==0) return false;
+    } while (!node_->count.compare_exchange_weak(c, c+1));
+    count_down();
+    node = node_;
+    return true;
+  }
+
   SharedObject& SharedObject::operator=(const SharedObject& ref) {
     // quick return if the old and new pointers point to the same object
     if (node == ref.node) return *this;
@@ -30,6 +30,7 @@
 #include "exception.hpp"
 #include <map>
 #include <vector>
+#include <atomic>
 
 namespace casadi {
 
@@ -108,6 +109,14 @@ namespace casadi {
      */
     void assignNodeNoCount(SharedObjectNode* node);
 
+    /** \brief Assign the node to a node class pointer if it is still referenced
+     *
+     * The check and the increase of the reference counter is atomic, so that a node which
+     * is being destroyed in another thread is never revived. Returns false if the
+     * reference counter was zero.
+     */
+    bool assignNodeIfAlive(SharedObjectNode* node);
+
     /// Get a const pointer to the node
     SharedObjectNode* get() const;
 
@@ -207,8 +216,9 @@ namespace casadi {
     const B shared_from_this() const;
 
   private:
-    /// Number of references pointing to the object
-    unsigned int count;
+    /// Number of references pointing to the object, atomic so that shared objects can be
+    /// copied and released from several threads
+    std::atomic<unsigned int> count;
 
     /// Weak pointer (non-owning) object for the object
     WeakRef* weak_ref_;
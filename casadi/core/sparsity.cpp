@@ -27,6 +27,12 @@
 #include "matrix.hpp"
 #include "std_vector_tools.hpp"
 #include <climits>
+#include <mutex>
+#include <atomic>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif // _WIN32
 
 using namespace std;
 
@@ -470,11 +476,85 @@ namespace casadi {
     }
   }
 
-  Sparsity::CachingMap& Sparsity::getCache() {
-    static CachingMap ret;
+  /// Global cache of sparsity patterns, sharded by the hash of the pattern
+  struct SparsityCache {
+    /// Number of shards
+    static const int n_shards = 64;
+
+    /// Weak (non-counted) references to the cached patterns, with a lock each
+    struct Shard {
+      std::mutex mtx;
+      std::unordered_multimap<std::size_t, SparsityInternal*> patterns;
+    };
+    std::vector<Shard> shards;
+
+    /// Statistics
+    std::atomic<size_t> hits, misses;
+
+    SparsityCache() : shards(n_shards), hits(0), misses(0) {
+#ifndef _WIN32
+      // Hold all locks while forking, so that a child process, e.g. a worker of a
+      // process map, does not inherit a lock held by another thread of the parent
+      pthread_atfork(lock_all, unlock_all, unlock_all);
+#endif // _WIN32
+    }
+
+    /// Shard corresponding to a hash value
+    Shard& shard(std::size_t h) { return shards[h % n_shards];}
+
+    /// Lock all shards
+    static void lock_all() {
+      for (auto&& s : get().shards) s.mtx.lock();
+    }
+
+    /// Unlock all shards
+    static void unlock_all() {
+      for (auto&& s : get().shards) s.mtx.unlock();
+    }
+
+    /// Access the global instance, never destroyed since patterns may outlive it
+    static SparsityCache& get() {
+      static SparsityCache* ret = new SparsityCache();
+      return *ret;
+    }
+  };
+
+  size_t Sparsity::cache_hits() {
+    return SparsityCache::get().hits;
+  }
+
+  size_t Sparsity::cache_misses() {
+    return SparsityCache::get().misses;
+  }
+
+  size_t Sparsity::cache_size() {
+    SparsityCache& cache = SparsityCache::get();
+    size_t ret = 0;
+    for (auto&& s : cache.shards) {
+      lock_guard<mutex> lock(s.mtx);
+      ret += s.patterns.size();
+    }
     return ret;
   }
 
+  void Sparsity::cache_reset_stats() {
+    SparsityCache& cache = SparsityCache::get();
+    cache.hits = 0;
+    cache.misses = 0;
+  }
+
+  void Sparsity::cache_remove(SparsityInternal* node, std::size_t h) {
+    SparsityCache::Shard& s = SparsityCache::get().shard(h);
+    lock_guard<mutex> lock(s.mtx);
+    auto eq = s.patterns.equal_range(h);
+    for (auto i=eq.first; i!=eq.second; ++i) {
+      if (i->second==node) {
+        s.patterns.erase(i);
+        return;
+      }
+    }
+  }
+
   const Sparsity& Sparsity::getScalar() {
     static ScalarSparsity ret;
     return ret;
@@ -613,6 +693,10 @@ namespace casadi {
     return (*this)->star_coloring2(ordering, cutoff);
   }
 
+  Sparsity Sparsity::acyclic_coloring(int ordering, int cutoff) const {
+    return (*this)->acyclic_coloring(ordering, cutoff);
+  }
+
   std::vector<int> Sparsity::largest_first() const {
     return (*this)->largest_first();
   }
@@ -670,92 +754,38 @@ namespace casadi {
     // Hash the pattern
     std::size_t h = hash_sparsity(nrow, ncol, colind, row);
 
-    // Get a reference to the cache
-    CachingMap& cache = getCache();
-
-    // Record the current number of buckets (for garbage collection below)
-    int bucket_count_before = cache.bucket_count();
-
-    // WORKAROUND, functions do not appear to work when bucket_count==0
-    if (bucket_count_before>0) {
+    // Look up the pattern in its shard of the cache, or create and cache a new one
+    SparsityCache& cache = SparsityCache::get();
+    SparsityCache::Shard& s = cache.shard(h);
+    Sparsity ret;
+    {
+      lock_guard<mutex> lock(s.mtx);
 
       // Find the range of patterns equal to the key (normally only zero or one)
-      pair<CachingMap::iterator, CachingMap::iterator> eq = cache.equal_range(h);
-
-      // Loop over maching patterns
-      for (CachingMap::iterator i=eq.first; i!=eq.second; ++i) {
-
-        // Get a weak reference to the cached sparsity pattern
-        WeakRef& wref = i->second;
-
-        // Check if the pattern still exists
-        if (wref.alive()) {
-
-          // Get an owning reference to the cached pattern
-          Sparsity ref = shared_cast<Sparsity>(wref.shared());
-
-          // Check if the pattern matches
-          if (ref.is_equal(nrow, ncol, colind, row)) {
-
-            // Found match!
-            assignNode(ref.get());
-            return;
-
-          } else { // There is a hash rowision (unlikely, but possible)
-            // Leave the pattern alone, continue to the next matching pattern
-            continue;
-          }
-        } else {
-
-          // Check if one of the other cache entries indeed has a matching sparsity
-          CachingMap::iterator j=i;
-          j++; // Start at the next matching key
-          for (; j!=eq.second; ++j) {
-            if (j->second.alive()) {
-
-              // Recover cached sparsity
-              Sparsity ref = shared_cast<Sparsity>(j->second.shared());
-
-              // Match found if sparsity matches
-              if (ref.is_equal(nrow, ncol, colind, row)) {
-                assignNode(ref.get());
-                return;
-              }
-            }
-          }
-
-          // The cached entry has been deleted, create a new one
-          assignNode(new SparsityInternal(nrow, ncol, colind, row));
-
-          // Cache this pattern
-          wref = *this;
-
-          // Return
-          return;
+      auto eq = s.patterns.equal_range(h);
+      for (auto i=eq.first; i!=eq.second; ++i) {
+        // A pattern which is being destroyed is still in the cache until its
+        // destructor acquires the lock, so its data can be accessed here
+        if (i->second->is_equal(nrow, ncol, colind, row) && ret.assignNodeIfAlive(i->second)) {
+          break;
         }
       }
-    }
-
-    // No matching sparsity pattern could be found, create a new one
-    assignNode(new SparsityInternal(nrow, ncol, colind, row));
 
-    // Cache this pattern
-    cache.insert(std::pair<std::size_t, WeakRef>(h, *this));
-
-    // Garbage collection (currently only supported for unordered_multimap)
-    int bucket_count_after = cache.bucket_count();
-
-    // We we increased the number of buckets, take time to garbage-collect deleted references
-    if (bucket_count_before!=bucket_count_after) {
-      CachingMap::const_iterator i=cache.begin();
-      while (i!=cache.end()) {
-        if (!i->second.alive()) {
-          i = cache.erase(i);
-        } else {
-          i++;
-        }
+      if (ret.is_null()) {
+        // No matching sparsity pattern could be found, create a new one
+        SparsityInternal* node = new SparsityInternal(nrow, ncol, colind, row);
+        ret.assignNode(node);
+        node->cached_ = true;
+        node->cache_hash_ = h;
+        s.patterns.insert(std::make_pair(h, node));
+        cache.misses++;
+      } else {
+        cache.hits++;
       }
     }
+
+    // Release the previous pattern outside of the lock, its destructor may need it
+    *this = ret;
   }
 
   Sparsity Sparsity::tril(const Sparsity& x, bool includeDiagonal) {
@@ -554,11 +554,24 @@ namespace casadi {
     */
     void removeDuplicates(std::vector<int>& SWIG_INOUT(mapping));
 
-#ifndef SWIG
-    typedef std::unordered_multimap<std::size_t, WeakRef> CachingMap;
+    ///@{
+    /** \brief Statistics of the global cache of sparsity patterns
+     *
+     * Number of patterns constructed from an existing cached pattern (hits), number of
+     * patterns that had to be allocated (misses) and number of patterns currently cached
+     * (size). The cache is thread-safe and sharded by the hash of the pattern.
+     */
+    static size_t cache_hits();
+    static size_t cache_misses();
+    static size_t cache_size();
+    ///@}
+
+    /// Reset the hit and miss counters of the global cache of sparsity patterns
+    static void cache_reset_stats();
 
-    /// Cached sparsity patterns
-    static CachingMap& getCache();
+#ifndef SWIG
+    /// Remove a pattern with hash \a h from the cache, called when the pattern is destroyed
+    static void cache_remove(SparsityInternal* node, std::size_t h);
 
     /// (Dense) scalar
     static const Sparsity& getScalar();
@@ -689,6 +702,21 @@ namespace casadi {
     */
     Sparsity star_coloring2(int ordering = 1, int cutoff = std::numeric_limits<int>::max()) const;
 
+    /** \brief Perform an acyclic coloring of a symmetric matrix:
+        A greedy distance-1 coloring where every cycle uses at least three colors,
+        so that the subgraph induced by any two colors is a forest.
+        Needs fewer colors than a star coloring, but the Hessian entries must be
+        recovered by substitution rather than directly.
+        Cf. Section 3 in
+          NEW ACYCLIC AND STAR COLORING ALGORITHMS WITH APPLICATION TO COMPUTING HESSIANS
+          A. H. GEBREMEDHIN, A. TARAFDAR, F. MANNE, A. POTHEN
+          SIAM J. SCI. COMPUT. Vol. 29, No. 3, pp. 1042–1072 (2007)
+
+        Ordering options: None (0), largest first (1)
+    */
+    Sparsity acyclic_coloring(int ordering = 1,
+                              int cutoff = std::numeric_limits<int>::max()) const;
+
     /** \brief Order the columns by decreasing degree */
     std::vector<int> largest_first() const;
 
@@ -36,7 +36,7 @@ namespace casadi {
 
   SparsityInternal::
   SparsityInternal(int nrow, int ncol, const int* colind, const int* row) :
-    sp_(2 + ncol+1 + colind[ncol]), btf_(0) {
+    sp_(2 + ncol+1 + colind[ncol]), btf_(0), cached_(false), cache_hash_(0) {
     sp_[0] = nrow;
     sp_[1] = ncol;
     std::copy(colind, colind+ncol+1, sp_.begin()+2);
@@ -45,6 +45,7 @@ namespace casadi {
   }
 
   SparsityInternal::~SparsityInternal() {
+    if (cached_) Sparsity::cache_remove(this, cache_hash_);
     if (btf_) delete btf_;
   }
 
@@ -3562,6 +3563,138 @@ namespace casadi {
     return Sparsity::triplet(size2(), num_colors, range(color.size()), color);
   }
 
+  /// Root of a tree in a disjoint-set forest, with path compression
+  static int disjoint_find(std::vector<int>& parent, int e) {
+    int r = e;
+    while (parent[r]>=0) r = parent[r];
+    while (parent[e]>=0) {
+      int next = parent[e];
+      parent[e] = r;
+      e = next;
+    }
+    return r;
+  }
+
+  Sparsity SparsityInternal::acyclic_coloring(int ordering, int cutoff) const {
+    casadi_assert_warning(size2()==size1(), "AcyclicColoring requires a square matrix, but got "
+                          << dim() << ".");
+    // Reorder, if necessary
+    if (ordering!=0) {
+      casadi_assert(ordering==1);
+
+      // Ordering
+      vector<int> ord = largest_first();
+
+      // Create a new sparsity pattern
+      Sparsity sp_permuted = pmult(ord, true, true, true);
+
+      // Acyclic coloring for the permuted matrix
+      Sparsity ret_permuted = sp_permuted.acyclic_coloring(0, cutoff);
+
+      // Permute result back
+      return ret_permuted.is_null() ? ret_permuted : ret_permuted.pmult(ord, true, false, false);
+    }
+
+    const int* colind = this->colind();
+    const int* row = this->row();
+
+    // An edge is identified by the smaller of the two nonzeros representing it
+    vector<int> mirror;
+    transpose(mirror);
+    for (int k=0; k<mirror.size(); ++k) mirror[k] = min(k, mirror[k]);
+
+    // Edges of the two-colored trees, as a disjoint-set forest
+    vector<int> parent(nnz(), -1);
+
+    // Neighbor of the current vertex that reached a tree first
+    vector<int> tree_vertex(nnz(), -1), tree_owner(nnz(), -1);
+
+    // Edge of the current vertex to the first neighbor with a given color
+    vector<int> color_vertex, color_edge;
+
+    vector<int> forbiddenColors;
+    forbiddenColors.reserve(size2());
+    vector<int> color(size2(), -1);
+
+    for (int v=0; v<size2(); ++v) {
+      for (int w_el=colind[v]; w_el<colind[v+1]; ++w_el) {
+        int w = row[w_el];
+        if (w==v || color[w]==-1) continue;
+
+        // Distance-1 coloring
+        forbiddenColors[color[w]] = v;
+
+        // A color that links two neighbors in the same two-colored tree closes a cycle
+        for (int x_el=colind[w]; x_el<colind[w+1]; ++x_el) {
+          int x = row[x_el];
+          if (x==v || x==w || color[x]==-1) continue;
+          int r = disjoint_find(parent, mirror[x_el]);
+          if (tree_vertex[r]!=v) {
+            tree_vertex[r] = v;
+            tree_owner[r] = w;
+          } else if (tree_owner[r]!=w) {
+            forbiddenColors[color[x]] = v;
+          }
+        }
+      }
+
+      // Smallest color that has not been forbidden
+      bool new_color = true;
+      for (int color_i=0; color_i<forbiddenColors.size(); ++color_i) {
+        // Break if color is ok
+        if (forbiddenColors[color_i]!=v) {
+          color[v] = color_i;
+          new_color = false;
+          break;
+        }
+      }
+
+      // New color if reached end
+      if (new_color) {
+        color[v] = forbiddenColors.size();
+        forbiddenColors.push_back(-1);
+        color_vertex.push_back(-1);
+        color_edge.push_back(-1);
+
+        // Cutoff if too many colors
+        if (forbiddenColors.size()>cutoff) {
+          return Sparsity();
+        }
+      }
+
+      // Add the edges to colored neighbors to the two-colored trees
+      for (int w_el=colind[v]; w_el<colind[v+1]; ++w_el) {
+        int w = row[w_el];
+        if (w==v || color[w]==-1) continue;
+        int e = mirror[w_el];
+
+        // Edges from v to vertices with the same color share a tree
+        if (color_vertex[color[w]]!=v) {
+          color_vertex[color[w]] = v;
+          color_edge[color[w]] = e;
+        } else {
+          int r1 = disjoint_find(parent, e), r2 = disjoint_find(parent, color_edge[color[w]]);
+          if (r1!=r2) parent[r1] = r2;
+        }
+
+        // Join the tree of w, if any
+        for (int x_el=colind[w]; x_el<colind[w+1]; ++x_el) {
+          int x = row[x_el];
+          if (x==v || color[x]!=color[v]) continue;
+          int r1 = disjoint_find(parent, e), r2 = disjoint_find(parent, mirror[x_el]);
+          if (r1!=r2) parent[r1] = r2;
+          break;
+        }
+      }
+    }
+
+    // Number of colors used
+    int num_colors = forbiddenColors.size();
+
+    // Return sparsity in sparse triplet format
+    return Sparsity::triplet(size2(), num_colors, range(color.size()), color);
+  }
+
   std::vector<int> SparsityInternal::largest_first() const {
     vector<int> degree = get_colind();
     int max_degree = 0;
@@ -46,6 +46,11 @@ namespace casadi {
     */
     mutable Sparsity::Btf* btf_;
 
+    /// Is the pattern registered in the cache, and with which hash
+    bool cached_;
+    std::size_t cache_hash_;
+    friend class Sparsity;
+
   public:
     /// Construct a sparsity pattern from arrays
     SparsityInternal(int nrow, int ncol, const int* colind, const int* row);
@@ -431,6 +436,11 @@ namespace casadi {
      */
     Sparsity star_coloring2(int ordering, int cutoff) const;
 
+    /** \brief A greedy acyclic coloring algorithm
+     * See description in public class.
+     */
+    Sparsity acyclic_coloring(int ordering, int cutoff) const;
+
     /// Order the columns by decreasing degree
     std::vector<int> largest_first() const;
 
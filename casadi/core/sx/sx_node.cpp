@@ -26,6 +26,7 @@
 #include "sx_node.hpp"
 #include <limits>
 #include <typeinfo>
+#include <stack>
 
 using namespace std;
 namespace casadi {
@@ -44,6 +45,62 @@ namespace casadi {
     }
   }
 
+  void SXNode::safe_delete(SXNode* n) {
+    // Quick return if still referenced
+    if (n->count!=0) return;
+
+    // Delete straight away if no dependencies
+    if (!n->hasDep()) {
+      delete n;
+      return;
+    }
+
+    // Stack of expressions to be deleted
+    std::stack<SXNode*> deletion_stack;
+
+    // Add the node to the deletion stack
+    deletion_stack.push(n);
+
+    // Process stack
+    while (!deletion_stack.empty()) {
+
+      // Top element
+      SXNode *t = deletion_stack.top();
+
+      // Check if the top element has dependencies with dependencies
+      bool added_to_stack = false;
+      for (int c2=0; c2<t->ndep(); ++c2) { // for all dependencies of the dependency
+
+        // Get the node of the dependency of the top element
+        // and remove it from the smart pointer
+        SXNode *n2 = t->dep(c2).assignNoDelete(casadi_limits<SXElem>::nan);
+
+        // Check if this is the only reference to the element
+        if (n2->count == 0) {
+
+          // Check if binary
+          if (!n2->hasDep()) {
+
+            // Delete straight away if not binary
+            delete n2;
+
+          } else {
+
+            // Add to deletion stack
+            deletion_stack.push(n2);
+            added_to_stack = true;
+          }
+        }
+      }
+
+      // Delete and pop from stack if nothing added to the stack
+      if (!added_to_stack) {
+        delete deletion_stack.top();
+        deletion_stack.pop();
+      }
+    } // while
+  }
+
   double SXNode::to_double() const {
     return numeric_limits<double>::quiet_NaN();
     /*  userOut<true, PL_WARN>() << "to_double() not defined for class " << typeid(*this).name() << std::endl;
@@ -33,6 +33,7 @@
 
 /** \brief  Scalar expression (which also works as a smart pointer class to this class) */
 #include "sx_elem.hpp"
+#include "../node_pool.hpp"
 
 
 /// \cond INTERNAL
@@ -42,7 +43,7 @@ namespace casadi {
       \author Joel Andersson
       \date 2010
   */
-  class SXNode {
+  class CASADI_EXPORT SXNode {
     friend class SXElem;
     friend class Matrix<SXElem>;
 
@@ -54,6 +55,16 @@ namespace casadi {
     /** \brief  destructor  */
     virtual ~SXNode();
 
+    ///@{
+    /** \brief  Nodes are allocated from a pool */
+    static void* operator new(size_t sz) { return NodePool::allocate(sz);}
+    static void operator delete(void* p, size_t sz) { NodePool::deallocate(p, sz);}
+    ///@}
+
+    /** \brief Delete a node which is no longer referenced, including any
+        dependencies that become unreferenced, without recursion */
+    static void safe_delete(SXNode* n);
+
     ///@{
     /** \brief  check properties of a node */
     virtual bool is_constant() const; // check if constant
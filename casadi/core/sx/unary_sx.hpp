@@ -59,8 +59,13 @@ class CASADI_EXPORT UnarySX : public SXNode {
       }
     }
 
-    /** \brief Destructor */
-    virtual ~UnarySX() {}
+    /** \brief Destructor
+    The dependency is released with SXNode::safe_delete, since the default destructor
+    can cause stack overflow for long chains of unary operations.
+    */
+    virtual ~UnarySX() {
+      safe_delete(dep_.assignNoDelete(casadi_limits<SXElem>::nan));
+    }
 
     virtual bool is_smooth() const { return operation_checker<SmoothChecker>(op_);}
 
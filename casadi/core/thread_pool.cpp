@@ -0,0 +1,192 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#include "thread_pool.hpp"
+#include <algorithm>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif // _WIN32
+
+using namespace std;
+
+namespace casadi {
+
+  // Identifier of the current process, to detect forked children
+  static long process_id() {
+#ifndef _WIN32
+    return getpid();
+#else // _WIN32
+    return 0;
+#endif // _WIN32
+  }
+
+  ThreadPool::ThreadPool(int n_threads)
+    : n_threads_(n_threads), n_job_(0), pid_(process_id()), ranges_(n_threads), task_(0),
+      job_(0), n_active_(0), stop_(false) {
+    casadi_assert_message(n_threads>=1, "ThreadPool: Number of threads must be positive");
+    for (auto&& r : ranges_) r.begin = r.end = 0;
+    threads_.reserve(n_threads-1);
+    for (int k=1; k<n_threads; ++k) {
+      threads_.push_back(thread(&ThreadPool::worker_loop, this, k));
+    }
+  }
+
+  ThreadPool::~ThreadPool() {
+    {
+      lock_guard<mutex> lock(mtx_);
+      stop_ = true;
+    }
+    start_cv_.notify_all();
+    for (auto&& t : threads_) t.join();
+  }
+
+  int ThreadPool::default_size() {
+    int n = thread::hardware_concurrency();
+    return n>0 ? n : 1;
+  }
+
+  ThreadPool& ThreadPool::shared() {
+    // Intentionally never destroyed, the workers sleep until the process exits
+    static ThreadPool* pool = new ThreadPool(default_size());
+    return *pool;
+  }
+
+  void ThreadPool::run(int n, const Task& task) {
+    run(n, task, n_threads_);
+  }
+
+  void ThreadPool::run(int n, const Task& task, int max_workers) {
+    // Number of workers taking part
+    int nw = std::min(std::min(n_threads_, max_workers), n);
+
+    // Execute serially if there is nothing to distribute, in a forked child process
+    // (no worker threads, possibly locked mutexes) or if the pool is busy
+    unique_lock<mutex> run_lock;
+    if (nw>1 && pid_==process_id()) run_lock = unique_lock<mutex>(run_mtx_, try_to_lock);
+    if (!run_lock.owns_lock()) {
+      for (int i=0; i<n; ++i) task(i, 0);
+      return;
+    }
+
+    // Split the iterations evenly
+    for (int k=0; k<nw; ++k) {
+      Range& r = ranges_[k];
+      lock_guard<mutex> lock(r.mtx);
+      r.begin = static_cast<int>((static_cast<long>(n)*k)/nw);
+      r.end = static_cast<int>((static_cast<long>(n)*(k+1))/nw);
+    }
+
+    // Wake up the workers
+    {
+      lock_guard<mutex> lock(mtx_);
+      task_ = &task;
+      error_ = exception_ptr();
+      n_job_ = nw;
+      n_active_ = nw-1;
+      job_++;
+    }
+    start_cv_.notify_all();
+
+    // Take part in the work
+    work(0);
+
+    // Wait for the workers to finish
+    exception_ptr error;
+    {
+      unique_lock<mutex> lock(mtx_);
+      done_cv_.wait(lock, [this]() { return n_active_==0;});
+      task_ = 0;
+      error = error_;
+    }
+    if (error) rethrow_exception(error);
+  }
+
+  void ThreadPool::worker_loop(int worker) {
+    unsigned long job = 0;
+    while (true) {
+      // Wait for a new job
+      {
+        unique_lock<mutex> lock(mtx_);
+        start_cv_.wait(lock, [this, job]() { return stop_ || job_!=job;});
+        if (stop_) return;
+        job = job_;
+        // Not taking part in this job
+        if (worker>=n_job_) continue;
+      }
+
+      // Execute
+      work(worker);
+
+      // Report completion
+      {
+        lock_guard<mutex> lock(mtx_);
+        if (--n_active_==0) done_cv_.notify_one();
+      }
+    }
+  }
+
+  void ThreadPool::work(int worker) {
+    int i;
+    while ((i=next(worker))>=0) {
+      try {
+        (*task_)(i, worker);
+      } catch(...) {
+        lock_guard<mutex> lock(mtx_);
+        if (!error_) error_ = current_exception();
+      }
+    }
+  }
+
+  int ThreadPool::next(int worker) {
+    // Take the next iteration from the own range
+    Range& own = ranges_[worker];
+    {
+      lock_guard<mutex> lock(own.mtx);
+      if (own.begin<own.end) return own.begin++;
+    }
+
+    // Steal the upper half of the remaining range of another worker
+    for (int k=1; k<n_job_; ++k) {
+      Range& victim = ranges_[(worker+k) % n_job_];
+      int begin, end;
+      {
+        lock_guard<mutex> lock(victim.mtx);
+        int rem = victim.end - victim.begin;
+        if (rem<=0) continue;
+        end = victim.end;
+        begin = victim.end - (rem+1)/2;
+        victim.end = begin;
+      }
+      // Keep the first stolen iteration, the rest becomes the own range
+      lock_guard<mutex> lock(own.mtx);
+      own.begin = begin+1;
+      own.end = end;
+      return begin;
+    }
+    return -1;
+  }
+
+} // namespace casadi
@@ -0,0 +1,155 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifndef CASADI_THREAD_POOL_HPP
+#define CASADI_THREAD_POOL_HPP
+
+#include "exception.hpp"
+#include "casadi_common.hpp"
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+namespace casadi {
+  /// \cond INTERNAL
+
+  /** \brief Pool of worker threads for parallel loops
+
+      Executes the iterations of a loop on a fixed set of std::threads, which are
+      created once and sleep between jobs. The iteration range is initially split
+      evenly between the workers. A worker that runs out of iterations steals half
+      of the remaining range of another worker, so iterations of varying cost are
+      balanced dynamically.
+
+      The calling thread takes part in the work as worker 0. Jobs submitted while the
+      pool is busy, e.g. from nested parallel loops, are executed serially by the
+      calling thread. So are jobs submitted from a forked child process, which does
+      not inherit the worker threads.
+
+      Parallel constructs normally use the process-wide pool returned by shared(),
+      limiting the number of workers per job, so that nested or concurrent parallel
+      constructs do not multiply the number of threads.
+  */
+  class CASADI_EXPORT ThreadPool {
+  public:
+    /// Loop body, called with the iteration index and the worker index
+    typedef std::function<void(int i, int worker)> Task;
+
+    /// Constructor, starts \a n_threads-1 worker threads
+    explicit ThreadPool(int n_threads);
+
+    /// Destructor, joins the worker threads
+    ~ThreadPool();
+
+    /// Number of workers, including the calling thread
+    int size() const { return n_threads_;}
+
+    /** \brief Execute task(i, worker) for i = 0, ..., n-1 and wait for completion
+
+        Exceptions thrown by the task are rethrown in the calling thread
+        after all workers have finished.
+    */
+    void run(int n, const Task& task);
+
+    /** \brief Execute task(i, worker) for i = 0, ..., n-1 with at most \a max_workers workers
+
+        The worker index passed to the task is less than \a max_workers.
+    */
+    void run(int n, const Task& task, int max_workers);
+
+    /// Default number of threads, the number of hardware threads
+    static int default_size();
+
+    /** \brief Process-wide pool with default_size() workers
+
+        Created at the first call and never destroyed.
+    */
+    static ThreadPool& shared();
+
+  private:
+    // Copying not allowed
+    ThreadPool(const ThreadPool&);
+    ThreadPool& operator=(const ThreadPool&);
+
+    /// Remaining iterations of a worker, padded to avoid false sharing
+    struct Range {
+      std::mutex mtx;
+      int begin, end;
+      char pad[64];
+    };
+
+    /// Main loop of the worker threads
+    void worker_loop(int worker);
+
+    /// Execute iterations until no work is left
+    void work(int worker);
+
+    /// Get the next iteration for a worker, stealing if needed, -1 if none left
+    int next(int worker);
+
+    /// Number of workers
+    int n_threads_;
+
+    /// Number of workers taking part in the current job
+    int n_job_;
+
+    /// Process that created the worker threads
+    long pid_;
+
+    /// Worker threads
+    std::vector<std::thread> threads_;
+
+    /// Iteration ranges, one per worker
+    std::vector<Range> ranges_;
+
+    /// Current task
+    const Task* task_;
+
+    /// Job counter, incremented for each job
+    unsigned long job_;
+
+    /// Number of worker threads still working on the current job
+    int n_active_;
+
+    /// Stop the workers
+    bool stop_;
+
+    /// First exception thrown during the current job
+    std::exception_ptr error_;
+
+    /// Synchronization of the job state
+    std::mutex mtx_;
+    std::condition_variable start_cv_, done_cv_;
+
+    /// Held while a job is executing
+    std::mutex run_mtx_;
+  };
+
+  /// \endcond
+} // namespace casadi
+
+#endif // CASADI_THREAD_POOL_HPP
@@ -101,6 +101,9 @@ namespace casadi {
     // Solve the linear system
     virtual void solve(void* mem, double* x, int nrhs, bool tr) const;
 
+    /// Use a Cholesky factorization for batched dense systems
+    virtual bool batch_cholesky() const { return true;}
+
     // Solve the system of equations <tt>Lx = b</tt>
     virtual void solve_cholesky(void* mem, double* x, int nrhs, bool tr) const;
 
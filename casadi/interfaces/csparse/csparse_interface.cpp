@@ -151,6 +151,53 @@ namespace casadi {
     casadi_assert(m->N!=0);
   }
 
+  bool CsparseInterface::refactorize(void* mem, const double* A) const {
+    auto m = static_cast<CsparseMemory*>(mem);
+    if (m->N==0) return false;
+
+    // Invalid entries are reported by the full factorization
+    for (int k=0; k<m->nnz(); ++k) {
+      if (isnan(A[k]) || isinf(A[k])) return false;
+    }
+
+    // Factors from the previous factorization, the rows of L are permuted
+    int n = m->A.n;
+    const int *Lp = m->N->L->p, *Li = m->N->L->i, *Up = m->N->U->p, *Ui = m->N->U->i;
+    double *Lx = m->N->L->x, *Ux = m->N->U->x;
+    const int *pinv = m->N->pinv, *q = m->S->q;
+    const int *colind = m->colind(), *row = m->row();
+    double* x = &m->temp_.front();
+
+    // Same threshold as in the partial pivoting of cs_lu
+    double tol = 1e-8;
+
+    // Left-looking LU factorization with fixed patterns and pivot sequence
+    for (int k=0; k<n; ++k) {
+      // Permuted column of A, scattered into the pattern of U(:, k) and L(:, k)
+      for (int p=Up[k]; p<Up[k+1]; ++p) x[Ui[p]] = 0;
+      for (int p=Lp[k]; p<Lp[k+1]; ++p) x[Li[p]] = 0;
+      int c = q ? q[k] : k;
+      for (int p=colind[c]; p<colind[c+1]; ++p) x[pinv[row[p]]] = A[p];
+
+      // Triangular solve, the entries of U(:, k) are stored in topological order
+      for (int p=Up[k]; p<Up[k+1]-1; ++p) {
+        int j = Ui[p];
+        double ujk = Ux[p] = x[j];
+        for (int pl=Lp[j]+1; pl<Lp[j+1]; ++pl) x[Li[pl]] -= Lx[pl]*ujk;
+      }
+
+      // Stability test for the pivot, the last entry of U(:, k)
+      double pivot = x[k], a = fabs(pivot);
+      for (int p=Lp[k]+1; p<Lp[k+1]; ++p) a = max(a, fabs(x[Li[p]]));
+      if (!(a>0 && fabs(pivot)>=a*tol)) return false;
+      Ux[Up[k+1]-1] = pivot;
+
+      // Scale the pivot column
+      for (int p=Lp[k]+1; p<Lp[k+1]; ++p) Lx[p] = x[Li[p]]/pivot;
+    }
+    return true;
+  }
+
   void CsparseInterface::solve(void* mem, double* x, int nrhs, bool tr) const {
     auto m = static_cast<CsparseMemory*>(mem);
     casadi_assert(m->N!=0);
@@ -94,6 +94,9 @@ namespace casadi {
     // Factorize the linear system
     virtual void factorize(void* mem, const double* A) const;
 
+    // Refactorize, reusing the pivot sequence and the pattern of the factors
+    virtual bool refactorize(void* mem, const double* A) const;
+
     // Solve the linear system
     virtual void solve(void* mem, double* x, int nrhs, bool tr) const;
 
@@ -465,7 +465,7 @@ namespace casadi {
     //const int* row = sp_jac_.row();
 
     // Factorize the linear system
-    linsol_.factorize(m.jac);
+    linsol_.factorize(m.jac, m.linsol_mem);
   }
 
   int KinsolInterface::psolve_wrapper(N_Vector u, N_Vector uscale, N_Vector fval,
@@ -484,7 +484,7 @@ namespace casadi {
   void KinsolInterface::psolve(KinsolMemory& m, N_Vector u, N_Vector uscale, N_Vector fval,
                             N_Vector fscale, N_Vector v, N_Vector tmp) const {
     // Solve the factorized system
-    linsol_.solve(NV_DATA_S(v));
+    linsol_.solve(NV_DATA_S(v), 1, false, m.linsol_mem);
   }
 
   int KinsolInterface::lsetup(KINMem kin_mem) {
@@ -156,7 +156,10 @@ namespace casadi {
     virtual void* alloc_memory() const { return new KinsolMemory(*this);}
 
     /** \brief Free memory block */
-    virtual void free_memory(void *mem) const { delete static_cast<KinsolMemory*>(mem);}
+    virtual void free_memory(void *mem) const {
+      Rootfinder::free_memory(mem);
+      delete static_cast<KinsolMemory*>(mem);
+    }
 
     /** \brief Initalize memory block */
     virtual void init_memory(void* mem) const;
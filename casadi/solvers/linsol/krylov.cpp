@@ -0,0 +1,586 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+
+#include "krylov.hpp"
+#include <limits>
+
+using namespace std;
+namespace casadi {
+
+  extern "C"
+  int CASADI_LINSOL_KRYLOV_EXPORT
+  casadi_register_linsol_krylov(LinsolInternal::Plugin* plugin) {
+    plugin->creator = Krylov::creator;
+    plugin->name = "krylov";
+    plugin->doc = Krylov::meta_doc.c_str();
+    plugin->version = 31;
+    return 0;
+  }
+
+  extern "C"
+  void CASADI_LINSOL_KRYLOV_EXPORT casadi_load_linsol_krylov() {
+    LinsolInternal::registerPlugin(casadi_register_linsol_krylov);
+  }
+
+  Krylov::Krylov(const std::string& name) :
+    LinsolInternal(name) {
+  }
+
+  Krylov::~Krylov() {
+    clear_memory();
+  }
+
+  Options Krylov::options_
+  = {{&LinsolInternal::options_},
+     {{"method",
+       {OT_STRING,
+        "Krylov method: 'gmres' (default) for general matrices, 'cg' for symmetric "
+        "positive definite matrices or 'minres' for symmetric matrices"}},
+      {"preconditioner",
+       {OT_STRING,
+        "Preconditioner: 'none', 'jacobi' (default), 'ilu0' (incomplete LU, "
+        "'gmres' only) or 'ic0' (incomplete Cholesky)"}},
+      {"tol",
+       {OT_DOUBLE,
+        "Tolerance on the residual norm, relative to the norm of the right-hand "
+        "side. For 'minres', the residual is measured in the preconditioner norm [1e-10]"}},
+      {"max_iter",
+       {OT_INT,
+        "Maximum number of iterations per right-hand side [1000]"}},
+      {"restart",
+       {OT_INT,
+        "Dimension of the Krylov subspace before restarting 'gmres' [30]"}},
+      {"jtimes",
+       {OT_FUNCTION,
+        "Function for matrix-vector products, taking the nonzeros of the matrix "
+        "and a vector and returning their product. The nonzeros are then only used "
+        "to form the preconditioner and can be any data needed by the function. "
+        "Transposed products are formed by reverse mode AD."}}
+     }
+  };
+
+  void Krylov::init(const Dict& opts) {
+    // Call the base class initializer
+    LinsolInternal::init(opts);
+
+    // Default options
+    method_ = GMRES;
+    pc_ = PC_JACOBI;
+    tol_ = 1e-10;
+    max_iter_ = 1000;
+    restart_ = 30;
+
+    // Read options
+    for (auto&& op : opts) {
+      if (op.first=="method") {
+        string method = op.second;
+        if (method=="gmres") {
+          method_ = GMRES;
+        } else if (method=="cg") {
+          method_ = CG;
+        } else if (method=="minres") {
+          method_ = MINRES;
+        } else {
+          casadi_error("Krylov: Unknown method \"" + method + "\", "
+                       "expected 'gmres', 'cg' or 'minres'");
+        }
+      } else if (op.first=="preconditioner") {
+        string pc = op.second;
+        if (pc=="none") {
+          pc_ = PC_NONE;
+        } else if (pc=="jacobi") {
+          pc_ = PC_JACOBI;
+        } else if (pc=="ilu0") {
+          pc_ = PC_ILU0;
+        } else if (pc=="ic0") {
+          pc_ = PC_IC0;
+        } else {
+          casadi_error("Krylov: Unknown preconditioner \"" + pc + "\", "
+                       "expected 'none', 'jacobi', 'ilu0' or 'ic0'");
+        }
+      } else if (op.first=="tol") {
+        tol_ = op.second;
+      } else if (op.first=="max_iter") {
+        max_iter_ = op.second;
+      } else if (op.first=="restart") {
+        restart_ = op.second;
+      } else if (op.first=="jtimes") {
+        jtimes_ = op.second;
+      }
+    }
+    casadi_assert_message(tol_>0, "Krylov: \"tol\" must be positive");
+    casadi_assert_message(max_iter_>0, "Krylov: \"max_iter\" must be positive");
+    casadi_assert_message(restart_>0, "Krylov: \"restart\" must be positive");
+    casadi_assert_message(method_==GMRES || pc_!=PC_ILU0,
+                          "Krylov: 'cg' and 'minres' require a symmetric preconditioner");
+    if (!jtimes_.is_null()) {
+      casadi_assert_message(jtimes_.n_in()==2 && jtimes_.n_out()==1,
+                            "Krylov: \"jtimes\" must have two inputs and one output");
+      // Transposed products for transposed 'gmres' solves, the other methods are symmetric.
+      // Only an error if such a solve is attempted.
+      if (method_==GMRES) {
+        try {
+          jtimes_tr_ = jtimes_.reverse(1);
+        } catch(exception& e) {
+          if (verbose()) log("Krylov::init",
+                             string("Cannot differentiate \"jtimes\": ") + e.what());
+        }
+      }
+    }
+  }
+
+  void Krylov::init_memory(void* mem) const {
+    LinsolInternal::init_memory(mem);
+    auto m = static_cast<KrylovMemory*>(mem);
+    for (const Function* f : {&jtimes_, &jtimes_tr_}) {
+      if (f->is_null()) continue;
+      m->arg.resize(max(m->arg.size(), f->sz_arg()));
+      m->res.resize(max(m->res.size(), f->sz_res()));
+      m->jt_iw.resize(max(m->jt_iw.size(), f->sz_iw()));
+      m->jt_w.resize(max(m->jt_w.size(), f->sz_w()));
+    }
+    m->shift = 0;
+    m->iter_count = 0;
+    m->residual = 0;
+    m->success = true;
+  }
+
+  void Krylov::reset(void* mem, const int* sp) const {
+    LinsolInternal::reset(mem, sp);
+    auto m = static_cast<KrylovMemory*>(mem);
+    casadi_assert_message(m->nrow()==m->ncol(), "Krylov: Matrix must be square");
+    int n = m->ncol(), nnz = m->nnz();
+    const int *colind = m->colind(), *row = m->row();
+
+    // Locate the diagonal
+    m->diag.assign(n, -1);
+    for (int c=0; c<n; ++c) {
+      for (int k=colind[c]; k<colind[c+1]; ++k) {
+        if (row[k]==c) m->diag[c] = k;
+      }
+      if (pc_==PC_ILU0 || pc_==PC_IC0) {
+        casadi_assert_message(m->diag[c]>=0, "Krylov: Incomplete factorization requires "
+                              "a structurally nonzero diagonal, missing in column " << c);
+      }
+    }
+
+    // Dimensions of the matrix-vector product function
+    if (!jtimes_.is_null()) {
+      casadi_assert_message(jtimes_.nnz_in(0)==nnz && jtimes_.nnz_in(1)==n
+                            && jtimes_.nnz_out(0)==n,
+                            "Krylov: \"jtimes\" has wrong dimensions. Expected "
+                            << nnz << " and " << n << " input and " << n << " output "
+                            "nonzeros, got " << jtimes_.nnz_in(0) << ", " << jtimes_.nnz_in(1)
+                            << " and " << jtimes_.nnz_out(0) << ".");
+    }
+
+    // Matrix and preconditioner
+    m->a.resize(nnz);
+    switch (pc_) {
+    case PC_NONE: m->pc.clear(); break;
+    case PC_JACOBI: m->pc.resize(n); break;
+    case PC_ILU0: case PC_IC0: m->pc.resize(nnz); break;
+    }
+    m->iw.resize(pc_==PC_ILU0 ? n : 0);
+
+    // Work vectors, all starting with a copy of the right-hand side
+    switch (method_) {
+    case CG:
+      m->v.resize(5*n);
+      m->h.clear();
+      break;
+    case MINRES:
+      m->v.resize(8*n);
+      m->h.clear();
+      break;
+    case GMRES:
+      m->v.resize((restart_+3)*n);
+      m->h.resize((restart_+1)*restart_ + 4*restart_ + 1);
+      break;
+    }
+  }
+
+  void Krylov::factorize(void* mem, const double* A) const {
+    auto m = static_cast<KrylovMemory*>(mem);
+    int n = m->ncol();
+    casadi_copy(A, m->nnz(), get_ptr(m->a));
+
+    switch (pc_) {
+    case PC_NONE:
+      break;
+    case PC_JACOBI:
+      for (int c=0; c<n; ++c) {
+        double d = m->diag[c]<0 ? 0 : A[m->diag[c]];
+        // Positive scaling for the symmetric methods
+        if (method_!=GMRES) d = fabs(d);
+        m->pc[c] = d==0 ? 1 : 1/d;
+      }
+      break;
+    case PC_ILU0:
+      ilu0(m);
+      break;
+    case PC_IC0:
+      // Shift the diagonal until the factorization succeeds
+      m->shift = 0;
+      while (!ic0(m, m->shift)) {
+        m->shift = m->shift==0 ? 1e-3 : 2*m->shift;
+        casadi_assert_message(m->shift<1e3, "Krylov: Incomplete Cholesky factorization "
+                              "failed, matrix not positive definite");
+      }
+      break;
+    }
+  }
+
+  void Krylov::ilu0(KrylovMemory* m) const {
+    // The columns of A are the rows of A', which is factorized as L*U.
+    // Strictly lower entries of each column hold L, the remaining ones U.
+    int n = m->ncol(), nnz = m->nnz();
+    const int *colind = m->colind(), *row = m->row();
+    double* lu = get_ptr(m->pc);
+    int* pos = get_ptr(m->iw);
+    casadi_copy(get_ptr(m->a), nnz, lu);
+
+    // Pivots are kept away from zero
+    double pmin = 1e-8*casadi_norm_inf(nnz, lu);
+    if (pmin==0) pmin = 1;
+
+    fill(pos, pos+n, -1);
+    for (int i=0; i<n; ++i) {
+      for (int k=colind[i]; k<colind[i+1]; ++k) pos[row[k]] = k;
+      for (int k=colind[i]; k<m->diag[i]; ++k) {
+        int j = row[k];
+        lu[k] /= lu[m->diag[j]];
+        // Update, dropping entries outside of the pattern
+        for (int kk=m->diag[j]+1; kk<colind[j+1]; ++kk) {
+          int p = pos[row[kk]];
+          if (p>=0) lu[p] -= lu[k]*lu[kk];
+        }
+      }
+      double& d = lu[m->diag[i]];
+      if (fabs(d)<pmin) d = d<0 ? -pmin : pmin;
+      for (int k=colind[i]; k<colind[i+1]; ++k) pos[row[k]] = -1;
+    }
+  }
+
+  bool Krylov::ic0(KrylovMemory* m, double shift) const {
+    // A = L*L', where the entries on and above the diagonal of column i of A
+    // give the pattern of row i of L. Up-looking, row by row.
+    int n = m->ncol();
+    const int *colind = m->colind(), *row = m->row();
+    const double* a = get_ptr(m->a);
+    double* l = get_ptr(m->pc);
+    double* w = get_ptr(m->v);
+    casadi_fill(w, n, 0.);
+    for (int i=0; i<n; ++i) {
+      for (int k=colind[i]; k<=m->diag[i]; ++k) w[row[k]] = a[k];
+      double d = w[i]*(1+shift);
+      for (int k=colind[i]; k<m->diag[i]; ++k) {
+        int j = row[k];
+        double s = w[j];
+        for (int kk=colind[j]; kk<m->diag[j]; ++kk) s -= l[kk]*w[row[kk]];
+        w[j] = s/l[m->diag[j]];
+        d -= w[j]*w[j];
+      }
+      if (!(d>0)) return false;
+      for (int k=colind[i]; k<m->diag[i]; ++k) {
+        l[k] = w[row[k]];
+        w[row[k]] = 0;
+      }
+      l[m->diag[i]] = sqrt(d);
+      w[i] = 0;
+    }
+    return true;
+  }
+
+  void Krylov::mv(KrylovMemory* m, const double* x, double* y, bool tr) const {
+    if (jtimes_.is_null()) {
+      casadi_fill(y, m->ncol(), 0.);
+      casadi_mv(get_ptr(m->a), get_ptr(m->sparsity), x, y, tr);
+    } else if (tr) {
+      // Adjoint sensitivity of the vector, the product is linear in the vector
+      casadi_assert_message(!jtimes_tr_.is_null(), "Krylov: Transposed 'gmres' solves "
+                            "require a differentiable \"jtimes\"");
+      m->arg[0] = get_ptr(m->a);
+      m->arg[1] = 0;
+      m->arg[2] = 0;
+      m->arg[3] = x;
+      m->res[0] = 0;
+      m->res[1] = y;
+      jtimes_tr_(get_ptr(m->arg), get_ptr(m->res), get_ptr(m->jt_iw), get_ptr(m->jt_w));
+    } else {
+      m->arg[0] = get_ptr(m->a);
+      m->arg[1] = x;
+      m->res[0] = y;
+      jtimes_(get_ptr(m->arg), get_ptr(m->res), get_ptr(m->jt_iw), get_ptr(m->jt_w));
+    }
+  }
+
+  void Krylov::precond(KrylovMemory* m, double* x, bool tr) const {
+    int n = m->ncol();
+    const int *colind = m->colind(), *row = m->row();
+    const int* diag = get_ptr(m->diag);
+    const double* pc = get_ptr(m->pc);
+    switch (pc_) {
+    case PC_NONE:
+      break;
+    case PC_JACOBI:
+      for (int i=0; i<n; ++i) x[i] *= pc[i];
+      break;
+    case PC_ILU0:
+      if (tr) {
+        // Solve L*U*x = b
+        for (int i=0; i<n; ++i) {
+          for (int k=colind[i]; k<diag[i]; ++k) x[i] -= pc[k]*x[row[k]];
+        }
+        for (int i=n-1; i>=0; --i) {
+          for (int k=diag[i]+1; k<colind[i+1]; ++k) x[i] -= pc[k]*x[row[k]];
+          x[i] /= pc[diag[i]];
+        }
+      } else {
+        // Solve U'*L'*x = b
+        for (int i=0; i<n; ++i) {
+          x[i] /= pc[diag[i]];
+          for (int k=diag[i]+1; k<colind[i+1]; ++k) x[row[k]] -= pc[k]*x[i];
+        }
+        for (int i=n-1; i>=0; --i) {
+          for (int k=colind[i]; k<diag[i]; ++k) x[row[k]] -= pc[k]*x[i];
+        }
+      }
+      break;
+    case PC_IC0:
+      // Solve L*L'*x = b
+      for (int i=0; i<n; ++i) {
+        for (int k=colind[i]; k<diag[i]; ++k) x[i] -= pc[k]*x[row[k]];
+        x[i] /= pc[diag[i]];
+      }
+      for (int i=n-1; i>=0; --i) {
+        x[i] /= pc[diag[i]];
+        for (int k=colind[i]; k<diag[i]; ++k) x[row[k]] -= pc[k]*x[i];
+      }
+      break;
+    }
+  }
+
+  /// Accumulate the statistics of a solve
+  static void update_stats(KrylovMemory* m, int iter, double res, double tol) {
+    m->iter_count += iter;
+    m->residual = max(m->residual, res);
+    if (!(res<=tol)) m->success = false;
+  }
+
+  void Krylov::cg(KrylovMemory* m, const double* b, double* x) const {
+    int n = m->ncol();
+    double *r = get_ptr(m->v) + n, *z = r + n, *p = z + n, *q = p + n;
+    casadi_fill(x, n, 0.);
+    double bnorm = casadi_norm_2(n, b);
+    if (bnorm==0) return;
+
+    casadi_copy(b, n, r);
+    casadi_copy(r, n, z);
+    precond(m, z, false);
+    casadi_copy(z, n, p);
+    double rz = casadi_dot(n, r, z), rnorm = bnorm;
+    int it;
+    for (it=0; it<max_iter_ && rnorm>tol_*bnorm; ++it) {
+      mv(m, p, q, false);
+      double pq = casadi_dot(n, p, q);
+      if (!(pq>0)) break; // Not positive definite
+      double alpha = rz/pq;
+      casadi_axpy(n, alpha, p, x);
+      casadi_axpy(n, -alpha, q, r);
+      rnorm = casadi_norm_2(n, r);
+      casadi_copy(r, n, z);
+      precond(m, z, false);
+      double rz_new = casadi_dot(n, r, z);
+      casadi_scal(n, rz_new/rz, p);
+      casadi_axpy(n, 1., z, p);
+      rz = rz_new;
+    }
+    update_stats(m, it, rnorm/bnorm, tol_);
+  }
+
+  void Krylov::minres(KrylovMemory* m, const double* b, double* x) const {
+    // Preconditioned MINRES, Paige and Saunders (1975)
+    int n = m->ncol();
+    double *r1 = get_ptr(m->v) + n, *r2 = r1 + n, *y = r2 + n, *v = y + n,
+      *w = v + n, *w1 = w + n, *w2 = w1 + n;
+    casadi_fill(x, n, 0.);
+    casadi_copy(b, n, r1);
+    casadi_copy(b, n, r2);
+    casadi_copy(b, n, y);
+    precond(m, y, false);
+    double beta1 = casadi_dot(n, b, y);
+    casadi_assert_message(beta1>=0, "Krylov: 'minres' requires a positive definite "
+                          "preconditioner");
+    if (beta1==0) return;
+    beta1 = sqrt(beta1);
+
+    casadi_fill(w, n, 0.);
+    casadi_fill(w2, n, 0.);
+    double oldb = 0, beta = beta1, dbar = 0, epsln = 0, phibar = beta1, cs = -1, sn = 0;
+    int it;
+    for (it=0; it<max_iter_ && phibar>tol_*beta1; ++it) {
+      // Lanczos step
+      for (int i=0; i<n; ++i) v[i] = y[i]/beta;
+      mv(m, v, y, false);
+      if (it>0) casadi_axpy(n, -beta/oldb, r1, y);
+      double alfa = casadi_dot(n, v, y);
+      casadi_axpy(n, -alfa/beta, r2, y);
+      double* t = r1;
+      r1 = r2;
+      r2 = y;
+      y = t;
+      casadi_copy(r2, n, y);
+      precond(m, y, false);
+      oldb = beta;
+      beta = casadi_dot(n, r2, y);
+      casadi_assert_message(beta>=0, "Krylov: 'minres' requires a positive definite "
+                            "preconditioner");
+      beta = sqrt(beta);
+
+      // Apply the previous rotation and compute the next one
+      double oldeps = epsln;
+      double delta = cs*dbar + sn*alfa;
+      double gbar = sn*dbar - cs*alfa;
+      epsln = sn*beta;
+      dbar = -cs*beta;
+      double gamma = max(hypot(gbar, beta), numeric_limits<double>::epsilon());
+      cs = gbar/gamma;
+      sn = beta/gamma;
+      double phi = cs*phibar;
+      phibar *= sn;
+
+      // Update the solution
+      t = w1;
+      w1 = w2;
+      w2 = w;
+      w = t;
+      for (int i=0; i<n; ++i) w[i] = (v[i] - oldeps*w1[i] - delta*w2[i])/gamma;
+      casadi_axpy(n, phi, w, x);
+    }
+    update_stats(m, it, phibar/beta1, tol_);
+  }
+
+  void Krylov::gmres(KrylovMemory* m, const double* b, double* x, bool tr) const {
+    // Restarted GMRES with right preconditioning, Saad and Schultz (1986)
+    int n = m->ncol(), mr = restart_;
+    double *V = get_ptr(m->v) + n, *w = V + (mr+1)*n;
+    double *H = get_ptr(m->h), *cs = H + (mr+1)*mr, *sn = cs + mr, *g = sn + mr, *y = g + mr + 1;
+    casadi_fill(x, n, 0.);
+    double bnorm = casadi_norm_2(n, b);
+    if (bnorm==0) return;
+
+    double rnorm;
+    int it = 0;
+    while (true) {
+      // Residual as the first basis vector
+      if (it==0) {
+        casadi_copy(b, n, V);
+      } else {
+        mv(m, x, V, tr);
+        for (int i=0; i<n; ++i) V[i] = b[i] - V[i];
+      }
+      rnorm = casadi_norm_2(n, V);
+      if (rnorm<=tol_*bnorm || it>=max_iter_) break;
+      casadi_scal(n, 1/rnorm, V);
+      casadi_fill(g, mr+1, 0.);
+      g[0] = rnorm;
+
+      // Arnoldi process, reducing the Hessenberg matrix to triangular form
+      int k = 0;
+      while (k<mr && it<max_iter_) {
+        double *vk = V + k*n, *hk = H + k*(mr+1);
+        casadi_copy(vk, n, w);
+        precond(m, w, tr);
+        mv(m, w, vk + n, tr);
+        for (int i=0; i<=k; ++i) {
+          hk[i] = casadi_dot(n, vk + n, V + i*n);
+          casadi_axpy(n, -hk[i], V + i*n, vk + n);
+        }
+        hk[k+1] = casadi_norm_2(n, vk + n);
+        if (hk[k+1]!=0) casadi_scal(n, 1/hk[k+1], vk + n);
+        for (int i=0; i<k; ++i) {
+          double t = cs[i]*hk[i] + sn[i]*hk[i+1];
+          hk[i+1] = cs[i]*hk[i+1] - sn[i]*hk[i];
+          hk[i] = t;
+        }
+        double d = hypot(hk[k], hk[k+1]);
+        cs[k] = d==0 ? 1 : hk[k]/d;
+        sn[k] = d==0 ? 0 : hk[k+1]/d;
+        hk[k] = d;
+        g[k+1] = -sn[k]*g[k];
+        g[k] *= cs[k];
+        k++;
+        it++;
+        if (fabs(g[k])<=tol_*bnorm || d==0) break;
+      }
+
+      // Least squares solution in the subspace, x += M^{-1}*V*y
+      for (int i=k-1; i>=0; --i) {
+        double s = g[i];
+        for (int j=i+1; j<k; ++j) s -= H[j*(mr+1)+i]*y[j];
+        y[i] = H[i*(mr+1)+i]==0 ? 0 : s/H[i*(mr+1)+i];
+      }
+      casadi_fill(w, n, 0.);
+      for (int i=0; i<k; ++i) casadi_axpy(n, y[i], V + i*n, w);
+      precond(m, w, tr);
+      casadi_axpy(n, 1., w, x);
+    }
+    update_stats(m, it, rnorm/bnorm, tol_);
+  }
+
+  void Krylov::solve(void* mem, double* x, int nrhs, bool tr) const {
+    auto m = static_cast<KrylovMemory*>(mem);
+    int n = m->ncol();
+    m->iter_count = 0;
+    m->residual = 0;
+    m->success = true;
+    double* b = get_ptr(m->v);
+    for (int k=0; k<nrhs; ++k) {
+      casadi_copy(x + k*n, n, b);
+      switch (method_) {
+      case CG: cg(m, b, x + k*n); break;
+      case MINRES: minres(m, b, x + k*n); break;
+      case GMRES: gmres(m, b, x + k*n, tr); break;
+      }
+    }
+    if (!m->success) {
+      casadi_warning("Krylov: No convergence after " << m->iter_count << " iterations, "
+                     "relative residual " << m->residual);
+    }
+  }
+
+  Dict Krylov::get_stats(void* mem) const {
+    Dict stats = LinsolInternal::get_stats(mem);
+    auto m = static_cast<KrylovMemory*>(mem);
+    stats["iter_count"] = m->iter_count;
+    stats["residual"] = m->residual;
+    stats["success"] = m->success;
+    if (pc_==PC_IC0) stats["pc_shift"] = m->shift;
+    return stats;
+  }
+
+} // namespace casadi
@@ -0,0 +1,183 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+
+#ifndef CASADI_KRYLOV_HPP
+#define CASADI_KRYLOV_HPP
+
+#include "casadi/core/function/linsol_internal.hpp"
+#include <casadi/solvers/linsol/casadi_linsol_krylov_export.h>
+
+/** \defgroup plugin_Linsol_krylov
+
+       Linsol based on preconditioned Krylov subspace iterations: conjugate
+       gradients for symmetric positive definite matrices, MINRES for symmetric
+       indefinite matrices and restarted GMRES for general matrices. The
+       preconditioner is a Jacobi (diagonal) scaling, an incomplete LU or an
+       incomplete Cholesky factorization without fill-in. Matrix-vector products
+       can be supplied by a Function, in which case the matrix itself need not be
+       formed. Memory use is linear in the number of unknowns and nonzeros.
+*/
+
+/** \pluginsection{Linsol,krylov} */
+
+/// \cond INTERNAL
+
+namespace casadi {
+
+  /** \brief Memory for Krylov  */
+  struct CASADI_LINSOL_KRYLOV_EXPORT KrylovMemory : public LinsolMemory {
+    // Copy of the nonzeros of A
+    std::vector<double> a;
+
+    // Position of the diagonal entry of each column, -1 if missing
+    std::vector<int> diag;
+
+    // Preconditioner: inverse diagonal or nonzeros of the incomplete factors
+    std::vector<double> pc;
+
+    // Diagonal shift of the incomplete Cholesky factorization
+    double shift;
+
+    // Work vectors: Krylov basis and other vectors of length n, small dense matrices
+    std::vector<double> v, h;
+    std::vector<int> iw;
+
+    // Work vectors for the matrix-vector product function
+    std::vector<const double*> arg;
+    std::vector<double*> res;
+    std::vector<int> jt_iw;
+    std::vector<double> jt_w;
+
+    // Statistics of the last solve
+    int iter_count;
+    double residual;
+    bool success;
+  };
+
+  /** \brief \pluginbrief{Linsol,krylov}
+
+      @copydoc Linsol_doc
+      @copydoc plugin_Linsol_krylov
+  */
+  class CASADI_LINSOL_KRYLOV_EXPORT Krylov : public LinsolInternal {
+  public:
+    // Constructor
+    Krylov(const std::string& name);
+
+    // Destructor
+    virtual ~Krylov();
+
+    // Get name of the plugin
+    virtual const char* plugin_name() const { return "krylov";}
+
+    /** \brief  Create a new Linsol */
+    static LinsolInternal* creator(const std::string& name) {
+      return new Krylov(name);
+    }
+
+    ///@{
+    /** \brief Options */
+    static Options options_;
+    virtual const Options& get_options() const { return options_;}
+    ///@}
+
+    // Initialize
+    virtual void init(const Dict& opts);
+
+    /** \brief Create memory block */
+    virtual void* alloc_memory() const { return new KrylovMemory();}
+
+    /** \brief Free memory block */
+    virtual void free_memory(void *mem) const { delete static_cast<KrylovMemory*>(mem);}
+
+    /** \brief Initalize memory block */
+    virtual void init_memory(void* mem) const;
+
+    // Set sparsity pattern
+    virtual void reset(void* mem, const int* sp) const;
+
+    // Factorize the linear system, i.e. form the preconditioner
+    virtual void factorize(void* mem, const double* A) const;
+
+    // Solve the linear system
+    virtual void solve(void* mem, double* x, int nrhs, bool tr) const;
+
+    /// Get all statistics
+    virtual Dict get_stats(void* mem) const;
+
+    /// A documentation string
+    static const std::string meta_doc;
+
+  private:
+    // Krylov methods
+    enum Method {CG, MINRES, GMRES};
+
+    // Preconditioners
+    enum Preconditioner {PC_NONE, PC_JACOBI, PC_ILU0, PC_IC0};
+
+    // Matrix-vector product y = A*x, or A'*x if tr
+    void mv(KrylovMemory* m, const double* x, double* y, bool tr) const;
+
+    // Apply the preconditioner in-place, x <- M^{-1}*x, or M^{-T}*x if tr
+    void precond(KrylovMemory* m, double* x, bool tr) const;
+
+    // Incomplete LU factorization, small pivots are perturbed
+    void ilu0(KrylovMemory* m) const;
+
+    // Incomplete Cholesky factorization with a diagonal shift, false on breakdown
+    bool ic0(KrylovMemory* m, double shift) const;
+
+    // Iterative solvers, starting from a zero initial guess
+    void cg(KrylovMemory* m, const double* b, double* x) const;
+    void minres(KrylovMemory* m, const double* b, double* x) const;
+    void gmres(KrylovMemory* m, const double* b, double* x, bool tr) const;
+
+    // Krylov method
+    Method method_;
+
+    // Preconditioner
+    Preconditioner pc_;
+
+    // Relative tolerance on the residual norm
+    double tol_;
+
+    // Maximum number of iterations
+    int max_iter_;
+
+    // Krylov subspace dimension before restarting (GMRES)
+    int restart_;
+
+    // Function for matrix-vector products (optional)
+    Function jtimes_;
+
+    // Its reverse derivative, for transposed products (GMRES)
+    Function jtimes_tr_;
+  };
+
+} // namespace casadi
+
+/// \endcond
+#endif // CASADI_KRYLOV_HPP
@@ -0,0 +1,118 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+      #include "krylov.hpp"
+      #include <string>
+
+      const std::string casadi::Krylov::meta_doc=
+      "\n"
+"Linsol based on preconditioned Krylov subspace iterations: conjugate\n"
+"gradients for symmetric positive definite matrices, MINRES for symmetric\n"
+"indefinite matrices and restarted GMRES for general matrices. The\n"
+"preconditioner is a Jacobi (diagonal) scaling, an incomplete LU or an\n"
+"incomplete Cholesky factorization without fill-in. Matrix-vector products can\n"
+"be supplied by a Function, in which case the matrix itself need not be formed.\n"
+"Memory use is linear in the number of unknowns and nonzeros.\n"
+"\n"
+"\n"
+">List of available options\n"
+"\n"
+"+-----------------+-----------------+-----------------+-----------------+\n"
+"|       Id        |      Type       |     Default     |   Description   |\n"
+"+=================+=================+=================+=================+\n"
+"| jtimes          | OT_FUNCTION     | GenericType()   | Function for    |\n"
+"|                 |                 |                 | matrix-vector   |\n"
+"|                 |                 |                 | products,       |\n"
+"|                 |                 |                 | taking the      |\n"
+"|                 |                 |                 | nonzeros of the |\n"
+"|                 |                 |                 | matrix and a    |\n"
+"|                 |                 |                 | vector and      |\n"
+"|                 |                 |                 | returning their |\n"
+"|                 |                 |                 | product. The    |\n"
+"|                 |                 |                 | nonzeros are    |\n"
+"|                 |                 |                 | then only used  |\n"
+"|                 |                 |                 | to form the     |\n"
+"|                 |                 |                 | preconditioner  |\n"
+"|                 |                 |                 | and can be any  |\n"
+"|                 |                 |                 | data needed by  |\n"
+"|                 |                 |                 | the function.   |\n"
+"|                 |                 |                 | Transposed      |\n"
+"|                 |                 |                 | products are    |\n"
+"|                 |                 |                 | formed by       |\n"
+"|                 |                 |                 | reverse mode    |\n"
+"|                 |                 |                 | AD.             |\n"
+"+-----------------+-----------------+-----------------+-----------------+\n"
+"| max_iter        | OT_INT          | 1000            | Maximum number  |\n"
+"|                 |                 |                 | of iterations   |\n"
+"|                 |                 |                 | per right-hand  |\n"
+"|                 |                 |                 | side [1000]     |\n"
+"+-----------------+-----------------+-----------------+-----------------+\n"
+"| method          | OT_STRING       | \"gmres\"         | Krylov method:  |\n"
+"|                 |                 |                 | 'gmres'         |\n"
+"|                 |                 |                 | (default) for   |\n"
+"|                 |                 |                 | general         |\n"
+"|                 |                 |                 | matrices, 'cg'  |\n"
+"|                 |                 |                 | for symmetric   |\n"
+"|                 |                 |                 | positive        |\n"
+"|                 |                 |                 | definite        |\n"
+"|                 |                 |                 | matrices or     |\n"
+"|                 |                 |                 | 'minres' for    |\n"
+"|                 |                 |                 | symmetric       |\n"
+"|                 |                 |                 | matrices        |\n"
+"+-----------------+-----------------+-----------------+-----------------+\n"
+"| preconditioner  | OT_STRING       | \"jacobi\"        | Preconditioner: |\n"
+"|                 |                 |                 | 'none',         |\n"
+"|                 |                 |                 | 'jacobi'        |\n"
+"|                 |                 |                 | (default),      |\n"
+"|                 |                 |                 | 'ilu0'          |\n"
+"|                 |                 |                 | (incomplete LU, |\n"
+"|                 |                 |                 | 'gmres' only)   |\n"
+"|                 |                 |                 | or 'ic0'        |\n"
+"|                 |                 |                 | (incomplete     |\n"
+"|                 |                 |                 | Cholesky)       |\n"
+"+-----------------+-----------------+-----------------+-----------------+\n"
+"| restart         | OT_INT          | 30              | Dimension of    |\n"
+"|                 |                 |                 | the Krylov      |\n"
+"|                 |                 |                 | subspace before |\n"
+"|                 |                 |                 | restarting      |\n"
+"|                 |                 |                 | 'gmres' [30]    |\n"
+"+-----------------+-----------------+-----------------+-----------------+\n"
+"| tol             | OT_DOUBLE       | 1e-10           | Tolerance on    |\n"
+"|                 |                 |                 | the residual    |\n"
+"|                 |                 |                 | norm, relative  |\n"
+"|                 |                 |                 | to the norm of  |\n"
+"|                 |                 |                 | the right-hand  |\n"
+"|                 |                 |                 | side. For       |\n"
+"|                 |                 |                 | 'minres', the   |\n"
+"|                 |                 |                 | residual is     |\n"
+"|                 |                 |                 | measured in the |\n"
+"|                 |                 |                 | preconditioner  |\n"
+"|                 |                 |                 | norm [1e-10]    |\n"
+"+-----------------+-----------------+-----------------+-----------------+\n"
+"\n"
+"\n"
+"\n"
+"\n"
+;
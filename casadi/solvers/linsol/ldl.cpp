@@ -0,0 +1,722 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#include "ldl.hpp"
+#include "casadi/core/sparsity_internal.hpp"
+#include "casadi/core/thread_pool.hpp"
+#include <condition_variable>
+#include <mutex>
+
+using namespace std;
+namespace casadi {
+
+  extern "C"
+  int CASADI_LINSOL_LDL_EXPORT
+  casadi_register_linsol_ldl(LinsolInternal::Plugin* plugin) {
+    plugin->creator = Ldl::creator;
+    plugin->name = "ldl";
+    plugin->doc = Ldl::meta_doc.c_str();
+    plugin->version = 31;
+    return 0;
+  }
+
+  extern "C"
+  void CASADI_LINSOL_LDL_EXPORT casadi_load_linsol_ldl() {
+    LinsolInternal::registerPlugin(casadi_register_linsol_ldl);
+  }
+
+  Ldl::Ldl(const std::string& name) :
+    LinsolInternal(name) {
+  }
+
+  Ldl::~Ldl() {
+    clear_memory();
+  }
+
+  Options Ldl::options_
+  = {{&LinsolInternal::options_},
+     {{"ordering",
+       {OT_STRING,
+        "Fill-reducing ordering: 'amd' (default) or 'natural'"}},
+      {"relax",
+       {OT_INT,
+        "Maximum number of columns of a supernode formed by merging "
+        "a supernode with its parent [16]"}},
+      {"nthreads",
+       {OT_INT,
+        "Maximum number of threads for the factorization, 0 for the "
+        "number of hardware threads [0]"}},
+      {"pivot_tol",
+       {OT_DOUBLE,
+        "Pivots smaller than pivot_tol times the largest entry of the matrix "
+        "are perturbed to this value [1e-8]"}},
+      {"max_refine",
+       {OT_INT,
+        "Maximum number of iterative refinement steps, performed only "
+        "if pivots were perturbed [3]"}}
+     }
+  };
+
+  void Ldl::init(const Dict& opts) {
+    // Call the base class initializer
+    LinsolInternal::init(opts);
+
+    // Default options
+    amd_ = true;
+    relax_ = 16;
+    nthreads_ = 0;
+    pivot_tol_ = 1e-8;
+    max_refine_ = 3;
+
+    // Read options
+    for (auto&& op : opts) {
+      if (op.first=="ordering") {
+        string ordering = op.second;
+        if (ordering=="amd") {
+          amd_ = true;
+        } else if (ordering=="natural") {
+          amd_ = false;
+        } else {
+          casadi_error("Ldl: Unknown ordering \"" + ordering + "\", "
+                       "expected 'amd' or 'natural'");
+        }
+      } else if (op.first=="relax") {
+        relax_ = op.second;
+      } else if (op.first=="nthreads") {
+        nthreads_ = op.second;
+      } else if (op.first=="pivot_tol") {
+        pivot_tol_ = op.second;
+      } else if (op.first=="max_refine") {
+        max_refine_ = op.second;
+      }
+    }
+    casadi_assert_message(nthreads_>=0, "Ldl: \"nthreads\" must be nonnegative");
+    casadi_assert_message(pivot_tol_>0, "Ldl: \"pivot_tol\" must be positive");
+    if (nthreads_==0) nthreads_ = ThreadPool::default_size();
+  }
+
+  /// Pattern of the permuted matrix A(p, p) + A(p, p)', with the diagonal
+  static Sparsity sym_perm(const Sparsity& A, const vector<int>& p) {
+    int n = A.size2();
+    vector<int> iperm(n);
+    for (int k=0; k<n; ++k) iperm[p[k]] = k;
+    vector<int> row, col;
+    row.reserve(2*A.nnz()+n);
+    col.reserve(2*A.nnz()+n);
+    const int *colind = A.colind(), *r = A.row();
+    for (int c=0; c<n; ++c) {
+      for (int k=colind[c]; k<colind[c+1]; ++k) {
+        row.push_back(iperm[r[k]]);
+        col.push_back(iperm[c]);
+        row.push_back(iperm[c]);
+        col.push_back(iperm[r[k]]);
+      }
+      row.push_back(c);
+      col.push_back(c);
+    }
+    return Sparsity::triplet(n, n, row, col);
+  }
+
+  void Ldl::reset(void* mem, const int* sp) const {
+    LinsolInternal::reset(mem, sp);
+    auto m = static_cast<LdlMemory*>(mem);
+    casadi_assert_message(m->nrow()==m->ncol(), "Ldl: Matrix must be square");
+    Sparsity A = Sparsity::compressed(m->sparsity);
+    int n = A.size2();
+
+    // Pair each column with a structurally zero diagonal, such as the constraint rows of
+    // a KKT system, with a neighbour, so that they can form a 2x2 pivot
+    vector<int> mate(n, -1);
+    Sparsity S = sym_perm(A, range(n));
+    const int *S_colind = S.colind(), *S_row = S.row();
+    for (int c=0; c<n; ++c) {
+      if (A.has_nz(c, c)) continue;
+      for (int el=S_colind[c]; el<S_colind[c+1]; ++el) {
+        int r = S_row[el];
+        if (r!=c && mate[r]<0 && A.has_nz(r, r)) {
+          mate[r] = c;
+          mate[c] = r;
+          break;
+        }
+      }
+    }
+
+    // Fill-reducing ordering of the compressed pattern, with the pairs kept together
+    vector<int> p;
+    if (amd_ && n>0) {
+      vector<int> group(n), first;
+      for (int c=0; c<n; ++c) {
+        if (mate[c]>=0 && mate[c]<c) {
+          group[c] = group[mate[c]];
+        } else {
+          group[c] = first.size();
+          first.push_back(c);
+        }
+      }
+      int ng = first.size();
+      vector<int> row, col;
+      for (int c=0; c<n; ++c) {
+        for (int el=S_colind[c]; el<S_colind[c+1]; ++el) {
+          row.push_back(group[S_row[el]]);
+          col.push_back(group[c]);
+        }
+      }
+      vector<int> pg = Sparsity::triplet(ng, ng, row, col)->amd(1);
+      for (int k=0; k<ng; ++k) {
+        // Zero diagonal last, the etree postorder then keeps it right after its mate
+        int c = first[pg[k]];
+        if (mate[c]<0) {
+          p.push_back(c);
+        } else if (A.has_nz(c, c)) {
+          p.push_back(c);
+          p.push_back(mate[c]);
+        } else {
+          p.push_back(mate[c]);
+          p.push_back(c);
+        }
+      }
+    } else {
+      p = range(n);
+    }
+
+    // Postorder the elimination tree, so that the columns of supernodes are contiguous
+    S = sym_perm(A, p);
+    vector<int> parent = S.etree();
+    vector<int> post = SparsityInternal::postorder(parent, n);
+    m->perm.resize(n);
+    for (int k=0; k<n; ++k) m->perm[k] = p[post[k]];
+    S = sym_perm(A, m->perm);
+    parent = S.etree();
+
+    // Column counts of the factor, the natural order is now a postorder
+    post = range(n);
+    vector<int> colcount = S->counts(get_ptr(parent), get_ptr(post), 0);
+
+    // Fundamental supernodes
+    vector<int> col_sn(n), sn_col;
+    for (int j=0; j<n; ++j) {
+      if (j==0 || parent[j-1]!=j || colcount[j-1]!=colcount[j]+1) {
+        sn_col.push_back(j);
+      }
+      col_sn[j] = sn_col.size()-1;
+    }
+    int ns = sn_col.size();
+    sn_col.push_back(n);
+
+    // Row structure of the fundamental supernodes, starting with the diagonal blocks
+    vector<vector<int> > sn_rows(ns);
+    for (int s=0; s<ns; ++s) {
+      for (int j=sn_col[s]; j<sn_col[s+1]; ++j) sn_rows[s].push_back(j);
+    }
+    vector<int> flag(n, -1), last(ns, -1);
+    S_colind = S.colind();
+    S_row = S.row();
+    for (int k=0; k<n; ++k) {
+      flag[k] = k;
+      for (int el=S_colind[k]; el<S_colind[k+1]; ++el) {
+        for (int j=S_row[el]; j<k && flag[j]!=k; j=parent[j]) {
+          flag[j] = k;
+          int s = col_sn[j];
+          if (s!=col_sn[k] && last[s]!=k) {
+            sn_rows[s].push_back(k);
+            last[s] = k;
+          }
+        }
+      }
+    }
+
+    // Relaxed supernodes: a supernode is merged into the next one if that is its
+    // parent and the result is not too wide, or if this separates a pair. The structure
+    // of a column is contained in the structure of its parent, extended with the parent.
+    m->sn_col.clear();
+    m->col_sn.resize(n);
+    vector<vector<int> > rel_rows;
+    for (int s=0; s<ns; ) {
+      int f = sn_col[s], s1 = s;
+      while (s1+1<ns && parent[sn_col[s1+1]-1]==sn_col[s1+1]
+             && (sn_col[s1+2]-f<=relax_
+                 || mate[m->perm[sn_col[s1+1]-1]]==m->perm[sn_col[s1+1]])) s1++;
+      m->sn_col.push_back(f);
+      rel_rows.push_back(range(f, sn_col[s1]));
+      rel_rows.back().insert(rel_rows.back().end(), sn_rows[s1].begin(), sn_rows[s1].end());
+      for (int j=f; j<sn_col[s1+1]; ++j) m->col_sn[j] = rel_rows.size()-1;
+      s = s1+1;
+    }
+    ns = m->sn_col.size();
+    m->sn_col.push_back(n);
+
+    // Flatten the row structure and allocate the dense blocks
+    m->sn_rowind.resize(ns+1);
+    m->sn_off.resize(ns+1);
+    m->sn_parent.resize(ns);
+    m->sn_rowind[0] = m->sn_off[0] = 0;
+    m->sn_row.clear();
+    m->max_w = m->max_nr = 0;
+    for (int s=0; s<ns; ++s) {
+      m->sn_row.insert(m->sn_row.end(), rel_rows[s].begin(), rel_rows[s].end());
+      m->sn_rowind[s+1] = m->sn_row.size();
+      int w = m->sn_col[s+1] - m->sn_col[s], nr = rel_rows[s].size();
+      m->sn_off[s+1] = m->sn_off[s] + w*nr;
+      m->sn_parent[s] = nr>w ? m->col_sn[rel_rows[s][w]] : -1;
+      m->max_w = max(m->max_w, w);
+      m->max_nr = max(m->max_nr, nr);
+    }
+    m->lx.resize(m->sn_off[ns]);
+    m->wx.resize(m->sn_off[ns]);
+    m->d.resize(n);
+    m->dsub.resize(n);
+    m->q.resize(n);
+    m->sn_npert.resize(ns);
+
+    // Descendants updating each supernode: rows of the descendant, grouped by target
+    m->upd_ind.assign(ns+1, 0);
+    for (int pass=0; pass<2; ++pass) {
+      vector<int> pos(m->upd_ind.begin(), m->upd_ind.end()-1);
+      for (int s=0; s<ns; ++s) {
+        int w = m->sn_col[s+1] - m->sn_col[s];
+        const int* rows = get_ptr(m->sn_row) + m->sn_rowind[s];
+        int nr = m->sn_rowind[s+1] - m->sn_rowind[s];
+        for (int c=w; c<nr; ++c) {
+          int t = m->col_sn[rows[c]];
+          if (c>w && m->col_sn[rows[c-1]]==t) continue;
+          if (pass==0) {
+            m->upd_ind[t+1]++;
+          } else {
+            m->upd_sn[pos[t]] = s;
+            m->upd_row[pos[t]++] = c;
+          }
+        }
+      }
+      if (pass==0) {
+        for (int t=0; t<ns; ++t) m->upd_ind[t+1] += m->upd_ind[t];
+        m->upd_sn.resize(m->upd_ind[ns]);
+        m->upd_row.resize(m->upd_ind[ns]);
+      }
+    }
+
+    // Map the nonzeros of A to the lower triangular part of the permuted matrix,
+    // entries in the upper triangle are used if there is no corresponding lower entry
+    vector<int> iperm(n);
+    for (int k=0; k<n; ++k) iperm[m->perm[k]] = k;
+    const int *colind = A.colind(), *row = A.row();
+    vector<int> loc(n, -1);
+    m->amap.resize(A.nnz());
+    vector<int> nz_col(A.nnz()), nz_row(A.nnz());
+    for (int c=0; c<n; ++c) {
+      for (int k=colind[c]; k<colind[c+1]; ++k) {
+        int pr = iperm[row[k]], pc = iperm[c];
+        if (pr<pc) {
+          if (A.has_nz(c, row[k])) {
+            pr = pc = -1;
+          } else {
+            swap(pr, pc);
+          }
+        }
+        nz_row[k] = pr;
+        nz_col[k] = pc;
+      }
+    }
+    for (int k=0; k<A.nnz(); ++k) {
+      m->amap[k] = -1;
+      if (nz_col[k]<0) continue;
+      int s = m->col_sn[nz_col[k]];
+      int nr = m->sn_rowind[s+1] - m->sn_rowind[s];
+      const int* rows = get_ptr(m->sn_row) + m->sn_rowind[s];
+      int i = lower_bound(rows, rows+nr, nz_row[k]) - rows;
+      m->amap[k] = m->sn_off[s] + (nz_col[k]-m->sn_col[s])*nr + i;
+    }
+
+    // Work vectors
+    m->a.resize(A.nnz());
+    m->w.resize(3*n);
+  }
+
+  void Ldl::factorize_sn(LdlMemory* m, int t, int* loc, double* w) const {
+    int f = m->sn_col[t], nc = m->sn_col[t+1] - f;
+    int nr = m->sn_rowind[t+1] - m->sn_rowind[t];
+    const int* rows = get_ptr(m->sn_row) + m->sn_rowind[t];
+    double* L = get_ptr(m->lx) + m->sn_off[t];
+
+    // Left-looking: subtract the updates L_s*D_s*L_s' from the descendants
+    double* u = w;
+    for (int i=0; i<nr; ++i) loc[rows[i]] = i;
+    for (int el=m->upd_ind[t]; el<m->upd_ind[t+1]; ++el) {
+      int s = m->upd_sn[el], c0 = m->upd_row[el];
+      int w_s = m->sn_col[s+1] - m->sn_col[s];
+      int nr_s = m->sn_rowind[s+1] - m->sn_rowind[s];
+      const int* rows_s = get_ptr(m->sn_row) + m->sn_rowind[s];
+      const double* L_s = get_ptr(m->lx) + m->sn_off[s];
+      const double* W_s = get_ptr(m->wx) + m->sn_off[s];
+      int c1 = c0+1;
+      while (c1<nr_s && m->col_sn[rows_s[c1]]==t) c1++;
+      for (int c=c0; c<c1; ++c) {
+        // Column c of the update, rows c, ..., nr_s-1
+        int len = nr_s - c;
+        fill_n(u, len, 0);
+        for (int k=0; k<w_s; ++k) {
+          double a = L_s[k*nr_s + c];
+          const double* wk = W_s + k*nr_s + c;
+          if (a!=0) for (int i=0; i<len; ++i) u[i] += a*wk[i];
+        }
+        double* tc = L + (rows_s[c]-f)*nr;
+        for (int i=0; i<len; ++i) tc[loc[rows_s[c+i]]] -= u[i];
+      }
+    }
+
+    // Symmetric copy of the diagonal block
+    double* F = w;
+    for (int j=0; j<nc; ++j) {
+      for (int i=0; i<nc; ++i) F[i+j*nc] = i>=j ? L[i+j*nr] : L[j+i*nr];
+    }
+
+    // Rows below the diagonal block
+    double* B = L + nc;
+    int mb = nr - nc;
+
+    // Bunch-Kaufman pivoting within the diagonal block
+    const double alpha = (1+sqrt(17.))/8;
+    int* q = get_ptr(m->q) + f;
+    double* d = get_ptr(m->d) + f;
+    double* dsub = get_ptr(m->dsub) + f;
+    for (int j=0; j<nc; ++j) q[j] = j;
+    int npert = 0;
+    for (int k=0; k<nc; ) {
+      // Largest off-diagonal entry in column k
+      double akk = fabs(F[k+k*nc]), colmax = 0;
+      int r = k;
+      for (int i=k+1; i<nc; ++i) {
+        if (fabs(F[i+k*nc])>colmax) {
+          colmax = fabs(F[i+k*nc]);
+          r = i;
+        }
+      }
+
+      // Choose between a 1x1 pivot at k or r and a 2x2 pivot at (k, r)
+      int kp = k, step = 1;
+      if (akk<alpha*colmax) {
+        double rowmax = 0;
+        for (int j=k; j<nc; ++j) if (j!=r) rowmax = max(rowmax, fabs(F[r+j*nc]));
+        if (akk*rowmax>=alpha*colmax*colmax) {
+          // 1x1 pivot at k
+        } else if (fabs(F[r+r*nc])>=alpha*rowmax) {
+          kp = r;
+        } else {
+          kp = r;
+          step = 2;
+        }
+      }
+
+      // Symmetric interchange of kk and kp
+      int kk = k + step - 1;
+      if (kp!=kk) {
+        for (int j=0; j<nc; ++j) swap(F[kk+j*nc], F[kp+j*nc]);
+        for (int i=0; i<nc; ++i) swap(F[i+kk*nc], F[i+kp*nc]);
+        for (int i=0; i<mb; ++i) swap(B[i+kk*nr], B[i+kp*nr]);
+        swap(q[kk], q[kp]);
+      }
+
+      if (step==1) {
+        // Perturb tiny pivots
+        double dk = F[k+k*nc];
+        if (fabs(dk)<m->delta) {
+          dk = dk<0 ? -m->delta : m->delta;
+          npert++;
+        }
+        d[k] = dk;
+        dsub[k] = 0;
+
+        // Rank-1 update of the trailing block, then scale the column
+        for (int j=k+1; j<nc; ++j) {
+          double fj = F[j+k*nc]/dk;
+          for (int i=k+1; i<nc; ++i) F[i+j*nc] -= F[i+k*nc]*fj;
+          for (int i=0; i<mb; ++i) B[i+j*nr] -= B[i+k*nr]*fj;
+        }
+        for (int i=k+1; i<nc; ++i) F[i+k*nc] /= dk;
+        for (int i=0; i<mb; ++i) B[i+k*nr] /= dk;
+      } else {
+        // 2x2 pivot block and its inverse
+        double a = F[k+k*nc], b = F[k+1+k*nc], c = F[k+1+(k+1)*nc];
+        double det = a*c - b*b;
+        d[k] = a;
+        d[k+1] = c;
+        dsub[k] = b;
+        dsub[k+1] = 0;
+
+        // Rank-2 update of the trailing block
+        for (int j=k+2; j<nc; ++j) {
+          double f0 = F[j+k*nc], f1 = F[j+(k+1)*nc];
+          double l0 = (c*f0 - b*f1)/det, l1 = (a*f1 - b*f0)/det;
+          for (int i=k+2; i<nc; ++i) F[i+j*nc] -= F[i+k*nc]*l0 + F[i+(k+1)*nc]*l1;
+          for (int i=0; i<mb; ++i) B[i+j*nr] -= B[i+k*nr]*l0 + B[i+(k+1)*nr]*l1;
+        }
+
+        // Scale the columns
+        for (int i=k+2; i<nc; ++i) {
+          double f0 = F[i+k*nc], f1 = F[i+(k+1)*nc];
+          F[i+k*nc] = (c*f0 - b*f1)/det;
+          F[i+(k+1)*nc] = (a*f1 - b*f0)/det;
+        }
+        for (int i=0; i<mb; ++i) {
+          double f0 = B[i+k*nr], f1 = B[i+(k+1)*nr];
+          B[i+k*nr] = (c*f0 - b*f1)/det;
+          B[i+(k+1)*nr] = (a*f1 - b*f0)/det;
+        }
+        F[k+1+k*nc] = 0;
+      }
+      k += step;
+    }
+    m->sn_npert[t] = npert;
+
+    // Store the unit lower triangular diagonal block
+    for (int j=0; j<nc; ++j) {
+      L[j+j*nr] = 1;
+      for (int i=j+1; i<nc; ++i) L[i+j*nr] = F[i+j*nc];
+    }
+
+    // Rows below the diagonal block multiplied by D, for the updates of the ancestors
+    double* W = get_ptr(m->wx) + m->sn_off[t] + nc;
+    for (int k=0; k<nc; ++k) {
+      if (k+1<nc && dsub[k]!=0) {
+        for (int i=0; i<mb; ++i) {
+          double b0 = B[i+k*nr], b1 = B[i+(k+1)*nr];
+          W[i+k*nr] = b0*d[k] + b1*dsub[k];
+          W[i+(k+1)*nr] = b0*dsub[k] + b1*d[k+1];
+        }
+        k++;
+      } else {
+        for (int i=0; i<mb; ++i) W[i+k*nr] = B[i+k*nr]*d[k];
+      }
+    }
+  }
+
+  // Minimum number of nonzeros in the factor for a parallel factorization
+  static const size_t ldl_min_parallel = 1<<15;
+
+  void Ldl::factorize(void* mem, const double* A) const {
+    auto m = static_cast<LdlMemory*>(mem);
+    int n = m->ncol(), ns = m->sn_col.size()-1;
+    double* lx = get_ptr(m->lx);
+
+    // Scatter the nonzeros of A, keeping a copy for the refinement
+    fill(m->lx.begin(), m->lx.end(), 0);
+    double amax = 0;
+    for (int k=0; k<m->nnz(); ++k) {
+      m->a[k] = A[k];
+      amax = max(amax, fabs(A[k]));
+      if (m->amap[k]>=0) lx[m->amap[k]] += A[k];
+    }
+    m->delta = pivot_tol_*(amax>0 ? amax : 1);
+
+    // Number of threads, small factorizations are not worth distributing
+    ThreadPool& pool = ThreadPool::shared();
+    int nt = min(nthreads_, pool.size());
+    if (m->lx.size()<ldl_min_parallel) nt = 1;
+
+    // Serial factorization, the supernodes are postordered
+    if (nt<2 || ns<2) {
+      vector<int> loc(n);
+      vector<double> w(m->max_w*m->max_w + m->max_nr);
+      for (int s=0; s<ns; ++s) factorize_sn(m, s, get_ptr(loc), get_ptr(w));
+      return;
+    }
+
+    // Parallel factorization: a supernode is ready when all its children are done
+    vector<int> nchild(ns, 0), ready;
+    for (int s=0; s<ns; ++s) {
+      if (m->sn_parent[s]>=0) nchild[m->sn_parent[s]]++;
+    }
+    for (int s=ns-1; s>=0; --s) if (nchild[s]==0) ready.push_back(s);
+    int ndone = 0;
+    bool failed = false;
+    mutex mtx;
+    condition_variable cv;
+    vector<vector<int> > loc(nt, vector<int>(n));
+    vector<vector<double> > w(nt, vector<double>(m->max_w*m->max_w + m->max_nr));
+    pool.run(nt, [&](int i, int worker) {
+      while (true) {
+        // Wait for a ready supernode
+        int s;
+        {
+          unique_lock<mutex> lock(mtx);
+          cv.wait(lock, [&]() { return !ready.empty() || ndone==ns || failed;});
+          if (ndone==ns || failed) return;
+          s = ready.back();
+          ready.pop_back();
+        }
+
+        // Factorize it
+        try {
+          factorize_sn(m, s, get_ptr(loc[worker]), get_ptr(w[worker]));
+        } catch (...) {
+          lock_guard<mutex> lock(mtx);
+          failed = true;
+          cv.notify_all();
+          throw;
+        }
+
+        // Release the parent
+        {
+          lock_guard<mutex> lock(mtx);
+          ndone++;
+          int p = m->sn_parent[s];
+          if (p>=0 && --nchild[p]==0) ready.push_back(p);
+        }
+        cv.notify_all();
+      }
+    });
+  }
+
+  void Ldl::solve_factors(LdlMemory* m, double* x) const {
+    int n = m->ncol(), ns = m->sn_col.size()-1;
+    double* y = get_ptr(m->w);
+    double* tmp = y + n;
+    const double* lx = get_ptr(m->lx);
+    const double* d = get_ptr(m->d);
+    const double* dsub = get_ptr(m->dsub);
+
+    // Permute the right-hand side
+    for (int k=0; k<n; ++k) y[k] = x[m->perm[k]];
+
+    // Forward substitution with the unit lower triangular factor
+    for (int s=0; s<ns; ++s) {
+      int f = m->sn_col[s], nc = m->sn_col[s+1] - f;
+      int nr = m->sn_rowind[s+1] - m->sn_rowind[s];
+      const int* rows = get_ptr(m->sn_row) + m->sn_rowind[s];
+      const int* q = get_ptr(m->q) + f;
+      const double* L = lx + m->sn_off[s];
+      for (int j=0; j<nc; ++j) tmp[j] = y[f+q[j]];
+      for (int j=0; j<nc; ++j) {
+        const double* cj = L + j*nr;
+        double yj = tmp[j];
+        for (int i=j+1; i<nc; ++i) tmp[i] -= cj[i]*yj;
+        for (int i=nc; i<nr; ++i) y[rows[i]] -= cj[i]*yj;
+      }
+      for (int j=0; j<nc; ++j) y[f+q[j]] = tmp[j];
+    }
+
+    // Block diagonal solve, in the pivoted order
+    for (int s=0; s<ns; ++s) {
+      int f = m->sn_col[s], nc = m->sn_col[s+1] - f;
+      const int* q = get_ptr(m->q) + f;
+      for (int j=0; j<nc; ++j) {
+        if (dsub[f+j]!=0) {
+          double a = d[f+j], b = dsub[f+j], c = d[f+j+1], det = a*c - b*b;
+          double y0 = y[f+q[j]], y1 = y[f+q[j+1]];
+          y[f+q[j]] = (c*y0 - b*y1)/det;
+          y[f+q[j+1]] = (a*y1 - b*y0)/det;
+          j++;
+        } else {
+          y[f+q[j]] /= d[f+j];
+        }
+      }
+    }
+
+    // Backward substitution with the transpose
+    for (int s=ns-1; s>=0; --s) {
+      int f = m->sn_col[s], nc = m->sn_col[s+1] - f;
+      int nr = m->sn_rowind[s+1] - m->sn_rowind[s];
+      const int* rows = get_ptr(m->sn_row) + m->sn_rowind[s];
+      const int* q = get_ptr(m->q) + f;
+      const double* L = lx + m->sn_off[s];
+      for (int j=0; j<nc; ++j) tmp[j] = y[f+q[j]];
+      for (int j=nc-1; j>=0; --j) {
+        const double* cj = L + j*nr;
+        double yj = tmp[j];
+        for (int i=j+1; i<nc; ++i) yj -= cj[i]*tmp[i];
+        for (int i=nc; i<nr; ++i) yj -= cj[i]*y[rows[i]];
+        tmp[j] = yj;
+      }
+      for (int j=0; j<nc; ++j) y[f+q[j]] = tmp[j];
+    }
+
+    // Permute back
+    for (int k=0; k<n; ++k) x[m->perm[k]] = y[k];
+  }
+
+  void Ldl::solve(void* mem, double* x, int nrhs, bool tr) const {
+    auto m = static_cast<LdlMemory*>(mem);
+    int n = m->ncol();
+    int npert = 0;
+    for (int p : m->sn_npert) npert += p;
+    int nrefine = npert>0 ? max_refine_ : 0;
+    vector<double> b, r;
+    if (nrefine>0) {
+      b.resize(n);
+      r.resize(n);
+    }
+    const int *colind = m->colind(), *row = m->row();
+
+    // The matrix is symmetric, tr has no effect
+    for (int k=0; k<nrhs; ++k) {
+      if (nrefine>0) copy(x, x+n, b.begin());
+      solve_factors(m, x);
+
+      // Iterative refinement, compensating for perturbed pivots
+      for (int it=0; it<nrefine; ++it) {
+        // Residual r = b - A*x, using the entries of A that define the factorization
+        copy(b.begin(), b.end(), r.begin());
+        for (int c=0; c<n; ++c) {
+          for (int el=colind[c]; el<colind[c+1]; ++el) {
+            if (m->amap[el]<0) continue;
+            int rr = row[el];
+            r[rr] -= m->a[el]*x[c];
+            if (rr!=c) r[c] -= m->a[el]*x[rr];
+          }
+        }
+        solve_factors(m, get_ptr(r));
+        for (int i=0; i<n; ++i) x[i] += r[i];
+      }
+      x += n;
+    }
+  }
+
+  int Ldl::neig(void* mem) const {
+    auto m = static_cast<LdlMemory*>(mem);
+    int n = m->ncol(), ret = 0;
+    for (int j=0; j<n; ++j) {
+      if (m->dsub[j]!=0) {
+        // 2x2 block: one negative eigenvalue if indefinite, else the sign of the trace
+        double a = m->d[j], b = m->dsub[j], c = m->d[j+1];
+        if (a*c - b*b<0) {
+          ret++;
+        } else if (a+c<0) {
+          ret += 2;
+        }
+        j++;
+      } else if (m->d[j]<0) {
+        ret++;
+      }
+    }
+    return ret;
+  }
+
+  int Ldl::rank(void* mem) const {
+    auto m = static_cast<LdlMemory*>(mem);
+    int npert = 0;
+    for (int p : m->sn_npert) npert += p;
+    return m->ncol() - npert;
+  }
+
+} // namespace casadi
@@ -0,0 +1,176 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifndef CASADI_LDL_HPP
+#define CASADI_LDL_HPP
+
+#include "casadi/core/function/linsol_internal.hpp"
+#include <casadi/solvers/linsol/casadi_linsol_ldl_export.h>
+
+/** \defgroup plugin_Linsol_ldl
+
+       Linsol based on a supernodal sparse LDL^T factorization for symmetric,
+       possibly indefinite, matrices. Bunch-Kaufman pivoting with 1x1 and 2x2
+       pivots is performed within the diagonal blocks of the supernodes, pivots
+       that remain too small are perturbed and corrected for by iterative
+       refinement. Independent subtrees of the elimination tree are factorized
+       in parallel.
+*/
+
+/** \pluginsection{Linsol,ldl} */
+
+/// \cond INTERNAL
+
+namespace casadi {
+
+  /** \brief Memory for Ldl  */
+  struct CASADI_LINSOL_LDL_EXPORT LdlMemory : public LinsolMemory {
+    // Fill-reducing (and postordered) permutation
+    std::vector<int> perm;
+
+    // Supernode of each column
+    std::vector<int> col_sn;
+
+    // First column and parent of each supernode
+    std::vector<int> sn_col, sn_parent;
+
+    // Row structure of each supernode (offsets and rows)
+    std::vector<int> sn_rowind, sn_row;
+
+    // Offset of the dense, column-major block of each supernode in lx
+    std::vector<int> sn_off;
+
+    // Supernodes updating each supernode, with the first row of the update
+    std::vector<int> upd_ind, upd_sn, upd_row;
+
+    // Position of each nonzero of A in lx, -1 if not used
+    std::vector<int> amap;
+
+    // Largest supernode
+    int max_w, max_nr;
+
+    // Nonzeros of the unit lower triangular factor and of its product with D
+    std::vector<double> lx, wx;
+
+    // Block diagonal D: diagonal and subdiagonal (nonzero for 2x2 pivots)
+    std::vector<double> d, dsub;
+
+    // Permutation within the supernodes from pivoting
+    std::vector<int> q;
+
+    // Number of perturbed pivots in each supernode
+    std::vector<int> sn_npert;
+
+    // Copy of the nonzeros of A for iterative refinement
+    std::vector<double> a;
+
+    // Pivot perturbation
+    double delta;
+
+    // Work vectors
+    std::vector<double> w;
+  };
+
+  /** \brief \pluginbrief{Linsol,ldl}
+
+      @copydoc Linsol_doc
+      @copydoc plugin_Linsol_ldl
+  */
+  class CASADI_LINSOL_LDL_EXPORT Ldl : public LinsolInternal {
+  public:
+    // Constructor
+    Ldl(const std::string& name);
+
+    // Destructor
+    virtual ~Ldl();
+
+    // Get name of the plugin
+    virtual const char* plugin_name() const { return "ldl";}
+
+    /** \brief  Create a new Linsol */
+    static LinsolInternal* creator(const std::string& name) {
+      return new Ldl(name);
+    }
+
+    ///@{
+    /** \brief Options */
+    static Options options_;
+    virtual const Options& get_options() const { return options_;}
+    ///@}
+
+    // Initialize
+    virtual void init(const Dict& opts);
+
+    /** \brief Create memory block */
+    virtual void* alloc_memory() const { return new LdlMemory();}
+
+    /** \brief Free memory block */
+    virtual void free_memory(void *mem) const { delete static_cast<LdlMemory*>(mem);}
+
+    // Set sparsity pattern, symbolic factorization
+    virtual void reset(void* mem, const int* sp) const;
+
+    // Factorize the linear system
+    virtual void factorize(void* mem, const double* A) const;
+
+    // Solve the linear system
+    virtual void solve(void* mem, double* x, int nrhs, bool tr) const;
+
+    /// Number of negative eigenvalues
+    virtual int neig(void* mem) const;
+
+    /// Matrix rank
+    virtual int rank(void* mem) const;
+
+    /// A documentation string
+    static const std::string meta_doc;
+
+  private:
+    // Factorize a supernode, given workspace
+    void factorize_sn(LdlMemory* m, int s, int* loc, double* w) const;
+
+    // Solve with the factorization, without refinement
+    void solve_factors(LdlMemory* m, double* x) const;
+
+    // Use approximate minimum degree ordering
+    bool amd_;
+
+    // Maximum number of columns of relaxed supernodes
+    int relax_;
+
+    // Maximum number of threads
+    int nthreads_;
+
+    // Relative threshold for pivot perturbation
+    double pivot_tol_;
+
+    // Maximum number of iterative refinement steps
+    int max_refine_;
+  };
+
+} // namespace casadi
+
+/// \endcond
+#endif // CASADI_LDL_HPP
@@ -0,0 +1,87 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+      #include "ldl.hpp"
+      #include <string>
+
+      const std::string casadi::Ldl::meta_doc=
+      "\n"
+"Linsol based on a supernodal sparse LDL^T factorization for symmetric,\n"
+"possibly indefinite, matrices. Bunch-Kaufman pivoting with 1x1 and 2x2\n"
+"pivots is performed within the diagonal blocks of the supernodes, pivots\n"
+"that remain too small are perturbed and corrected for by iterative\n"
+"refinement. Independent subtrees of the elimination tree are factorized in\n"
+"parallel.\n"
+"\n"
+"\n"
+">List of available options\n"
+"\n"
+"+-----------------+-----------------+-----------------+-----------------+\n"
+"|       Id        |      Type       |     Default     |   Description   |\n"
+"+=================+=================+=================+=================+\n"
+"| max_refine      | OT_INT          | 3               | Maximum number  |\n"
+"|                 |                 |                 | of iterative    |\n"
+"|                 |                 |                 | refinement      |\n"
+"|                 |                 |                 | steps,          |\n"
+"|                 |                 |                 | performed only  |\n"
+"|                 |                 |                 | if pivots were  |\n"
+"|                 |                 |                 | perturbed [3]   |\n"
+"+-----------------+-----------------+-----------------+-----------------+\n"
+"| nthreads        | OT_INT          | 0               | Maximum number  |\n"
+"|                 |                 |                 | of threads for  |\n"
+"|                 |                 |                 | the             |\n"
+"|                 |                 |                 | factorization,  |\n"
+"|                 |                 |                 | 0 for the       |\n"
+"|                 |                 |                 | number of       |\n"
+"|                 |                 |                 | hardware        |\n"
+"|                 |                 |                 | threads [0]     |\n"
+"+-----------------+-----------------+-----------------+-----------------+\n"
+"| ordering        | OT_STRING       | \"amd\"           | Fill-reducing   |\n"
+"|                 |                 |                 | ordering: 'amd' |\n"
+"|                 |                 |                 | (default) or    |\n"
+"|                 |                 |                 | 'natural'       |\n"
+"+-----------------+-----------------+-----------------+-----------------+\n"
+"| pivot_tol       | OT_DOUBLE       | 1e-8            | Pivots smaller  |\n"
+"|                 |                 |                 | than pivot_tol  |\n"
+"|                 |                 |                 | times the       |\n"
+"|                 |                 |                 | largest entry   |\n"
+"|                 |                 |                 | of the matrix   |\n"
+"|                 |                 |                 | are perturbed   |\n"
+"|                 |                 |                 | to this value   |\n"
+"|                 |                 |                 | [1e-8]          |\n"
+"+-----------------+-----------------+-----------------+-----------------+\n"
+"| relax           | OT_INT          | 16              | Maximum number  |\n"
+"|                 |                 |                 | of columns of a |\n"
+"|                 |                 |                 | supernode       |\n"
+"|                 |                 |                 | formed by       |\n"
+"|                 |                 |                 | merging a       |\n"
+"|                 |                 |                 | supernode with  |\n"
+"|                 |                 |                 | its parent [16] |\n"
+"+-----------------+-----------------+-----------------+-----------------+\n"
+"\n"
+"\n"
+"\n"
+"\n"
+;
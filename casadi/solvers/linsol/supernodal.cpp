@@ -0,0 +1,355 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#include "supernodal.hpp"
+#include "casadi/core/sparsity_internal.hpp"
+
+using namespace std;
+namespace casadi {
+
+  extern "C"
+  int CASADI_LINSOL_SUPERNODAL_EXPORT
+  casadi_register_linsol_supernodal(LinsolInternal::Plugin* plugin) {
+    plugin->creator = Supernodal::creator;
+    plugin->name = "supernodal";
+    plugin->doc = Supernodal::meta_doc.c_str();
+    plugin->version = 31;
+    return 0;
+  }
+
+  extern "C"
+  void CASADI_LINSOL_SUPERNODAL_EXPORT casadi_load_linsol_supernodal() {
+    LinsolInternal::registerPlugin(casadi_register_linsol_supernodal);
+  }
+
+  Supernodal::Supernodal(const std::string& name) :
+    LinsolInternal(name) {
+  }
+
+  Supernodal::~Supernodal() {
+    clear_memory();
+  }
+
+  Options Supernodal::options_
+  = {{&LinsolInternal::options_},
+     {{"ordering",
+       {OT_STRING,
+        "Fill-reducing ordering: 'amd' (default) or 'natural'"}}
+     }
+  };
+
+  void Supernodal::init(const Dict& opts) {
+    // Call the base class initializer
+    LinsolInternal::init(opts);
+
+    // Default options
+    amd_ = true;
+
+    // Read options
+    for (auto&& op : opts) {
+      if (op.first=="ordering") {
+        string ordering = op.second;
+        if (ordering=="amd") {
+          amd_ = true;
+        } else if (ordering=="natural") {
+          amd_ = false;
+        } else {
+          casadi_error("Supernodal: Unknown ordering \"" + ordering + "\", "
+                       "expected 'amd' or 'natural'");
+        }
+      }
+    }
+  }
+
+  void Supernodal::init_memory(void* mem) const {
+    LinsolInternal::init_memory(mem);
+  }
+
+  /// Pattern of the permuted matrix A(p, p) + A(p, p)', with the diagonal
+  static Sparsity sym_perm(const Sparsity& A, const vector<int>& p) {
+    int n = A.size2();
+    vector<int> iperm(n);
+    for (int k=0; k<n; ++k) iperm[p[k]] = k;
+    vector<int> row, col;
+    row.reserve(2*A.nnz()+n);
+    col.reserve(2*A.nnz()+n);
+    const int *colind = A.colind(), *r = A.row();
+    for (int c=0; c<n; ++c) {
+      for (int k=colind[c]; k<colind[c+1]; ++k) {
+        row.push_back(iperm[r[k]]);
+        col.push_back(iperm[c]);
+        row.push_back(iperm[c]);
+        col.push_back(iperm[r[k]]);
+      }
+      row.push_back(c);
+      col.push_back(c);
+    }
+    return Sparsity::triplet(n, n, row, col);
+  }
+
+  void Supernodal::reset(void* mem, const int* sp) const {
+    LinsolInternal::reset(mem, sp);
+    auto m = static_cast<SupernodalMemory*>(mem);
+    casadi_assert_message(m->nrow()==m->ncol(), "Supernodal: Matrix must be square");
+    Sparsity A = Sparsity::compressed(m->sparsity);
+    int n = A.size2();
+
+    // Fill-reducing ordering
+    vector<int> p;
+    if (amd_ && n>0) {
+      p = A->amd(1);
+      p.resize(n);
+    } else {
+      p = range(n);
+    }
+
+    // Postorder the elimination tree, so that the columns of supernodes are contiguous
+    Sparsity S = sym_perm(A, p);
+    vector<int> parent = S.etree();
+    vector<int> post = SparsityInternal::postorder(parent, n);
+    m->perm.resize(n);
+    for (int k=0; k<n; ++k) m->perm[k] = p[post[k]];
+    S = sym_perm(A, m->perm);
+    parent = S.etree();
+
+    // Column counts of the factor, the natural order is now a postorder
+    post = range(n);
+    vector<int> colcount = S->counts(get_ptr(parent), get_ptr(post), 0);
+
+    // Fundamental supernodes: a column is merged with its only child if the column
+    // structure of the child is that of the parent, extended with the child
+    m->col_sn.resize(n);
+    m->sn_col.clear();
+    for (int j=0; j<n; ++j) {
+      if (j==0 || parent[j-1]!=j || colcount[j-1]!=colcount[j]+1) {
+        m->sn_col.push_back(j);
+      }
+      m->col_sn[j] = m->sn_col.size()-1;
+    }
+    int ns = m->sn_col.size();
+    m->sn_col.push_back(n);
+
+    // Row structure of the supernodes, starting with the diagonal blocks
+    vector<vector<int> > sn_rows(ns);
+    for (int s=0; s<ns; ++s) {
+      for (int j=m->sn_col[s]; j<m->sn_col[s+1]; ++j) sn_rows[s].push_back(j);
+    }
+
+    // Add the rows below the diagonal blocks, traversing the row subtrees
+    vector<int> flag(n, -1), last(ns, -1);
+    const int *S_colind = S.colind(), *S_row = S.row();
+    for (int k=0; k<n; ++k) {
+      flag[k] = k;
+      for (int el=S_colind[k]; el<S_colind[k+1]; ++el) {
+        for (int j=S_row[el]; j<k && flag[j]!=k; j=parent[j]) {
+          flag[j] = k;
+          int s = m->col_sn[j];
+          if (s!=m->col_sn[k] && last[s]!=k) {
+            sn_rows[s].push_back(k);
+            last[s] = k;
+          }
+        }
+      }
+    }
+
+    // Flatten the row structure and allocate the dense blocks
+    m->sn_rowind.resize(ns+1);
+    m->sn_off.resize(ns+1);
+    m->sn_rowind[0] = m->sn_off[0] = 0;
+    m->sn_row.clear();
+    for (int s=0; s<ns; ++s) {
+      m->sn_row.insert(m->sn_row.end(), sn_rows[s].begin(), sn_rows[s].end());
+      m->sn_rowind[s+1] = m->sn_row.size();
+      int w = m->sn_col[s+1] - m->sn_col[s];
+      m->sn_off[s+1] = m->sn_off[s] + w*sn_rows[s].size();
+    }
+    m->lx.resize(m->sn_off[ns]);
+
+    // Map the nonzeros of A to the lower triangular part of the permuted matrix,
+    // entries in the upper triangle are used if there is no corresponding lower entry
+    vector<int> iperm(n);
+    for (int k=0; k<n; ++k) iperm[m->perm[k]] = k;
+    const int *colind = A.colind(), *row = A.row();
+    vector<int> loc(n, -1);
+    m->amap.resize(A.nnz());
+    vector<int> nz_col(A.nnz()), nz_row(A.nnz());
+    for (int c=0; c<n; ++c) {
+      for (int k=colind[c]; k<colind[c+1]; ++k) {
+        int pr = iperm[row[k]], pc = iperm[c];
+        if (pr<pc) {
+          if (A.has_nz(c, row[k])) {
+            pr = pc = -1;
+          } else {
+            swap(pr, pc);
+          }
+        }
+        nz_row[k] = pr;
+        nz_col[k] = pc;
+      }
+    }
+    // Nonzeros sorted by supernode
+    vector<int> sn_nzind(ns+1, 0), sn_nz(A.nnz());
+    for (int k=0; k<A.nnz(); ++k) {
+      m->amap[k] = -1;
+      if (nz_col[k]>=0) sn_nzind[m->col_sn[nz_col[k]]+1]++;
+    }
+    for (int s=0; s<ns; ++s) sn_nzind[s+1] += sn_nzind[s];
+    vector<int> pos(sn_nzind.begin(), sn_nzind.end()-1);
+    for (int k=0; k<A.nnz(); ++k) {
+      if (nz_col[k]>=0) sn_nz[pos[m->col_sn[nz_col[k]]]++] = k;
+    }
+    for (int s=0; s<ns; ++s) {
+      int nr = m->sn_rowind[s+1] - m->sn_rowind[s];
+      const int* rows = get_ptr(m->sn_row) + m->sn_rowind[s];
+      for (int i=0; i<nr; ++i) loc[rows[i]] = i;
+      for (int el=sn_nzind[s]; el<sn_nzind[s+1]; ++el) {
+        int k = sn_nz[el];
+        m->amap[k] = m->sn_off[s] + (nz_col[k]-m->sn_col[s])*nr + loc[nz_row[k]];
+      }
+    }
+
+    // Work vectors
+    m->iw.resize(n);
+    m->w.resize(n);
+  }
+
+  void Supernodal::factorize(void* mem, const double* A) const {
+    auto m = static_cast<SupernodalMemory*>(mem);
+    int ns = m->sn_col.size()-1;
+    int* loc = get_ptr(m->iw);
+    double* u = get_ptr(m->w);
+    double* lx = get_ptr(m->lx);
+
+    // Scatter the nonzeros of A
+    fill(m->lx.begin(), m->lx.end(), 0);
+    for (int k=0; k<m->nnz(); ++k) {
+      if (m->amap[k]>=0) lx[m->amap[k]] += A[k];
+    }
+
+    // Right-looking factorization, one supernode at a time
+    for (int s=0; s<ns; ++s) {
+      int f = m->sn_col[s], w = m->sn_col[s+1] - f;
+      int nr = m->sn_rowind[s+1] - m->sn_rowind[s];
+      const int* rows = get_ptr(m->sn_row) + m->sn_rowind[s];
+      double* L = lx + m->sn_off[s];
+
+      // Dense Cholesky factorization of the diagonal block, scaling the rows below
+      for (int j=0; j<w; ++j) {
+        double* cj = L + j*nr;
+        double d = cj[j];
+        casadi_assert_message(d>0, "Supernodal: Matrix not positive definite, pivot "
+                              << d << " for column " << m->perm[f+j]);
+        d = sqrt(d);
+        for (int i=j; i<nr; ++i) cj[i] /= d;
+        for (int jj=j+1; jj<w; ++jj) {
+          double* cjj = L + jj*nr;
+          double a = cj[jj];
+          if (a!=0) for (int i=jj; i<nr; ++i) cjj[i] -= a*cj[i];
+        }
+      }
+
+      // Update the ancestors with the rows below the diagonal block, B*B'
+      int mr = nr - w;
+      const double* B = L + w;
+      for (int c0=0; c0<mr; ) {
+        // Columns of the update going to the same target supernode
+        int t = m->col_sn[rows[w+c0]];
+        int c1 = c0+1;
+        while (c1<mr && m->col_sn[rows[w+c1]]==t) c1++;
+
+        // Relative position of the rows in the target supernode
+        int nr_t = m->sn_rowind[t+1] - m->sn_rowind[t];
+        const int* rows_t = get_ptr(m->sn_row) + m->sn_rowind[t];
+        for (int i=0; i<nr_t; ++i) loc[rows_t[i]] = i;
+
+        for (int c=c0; c<c1; ++c) {
+          // Column c of the update, rows c, ..., mr-1
+          int len = mr - c;
+          fill_n(u, len, 0);
+          for (int k=0; k<w; ++k) {
+            const double* bk = B + k*nr + c;
+            double a = bk[0];
+            if (a!=0) for (int i=0; i<len; ++i) u[i] += a*bk[i];
+          }
+
+          // Subtract from the target column
+          double* tc = lx + m->sn_off[t] + (rows[w+c]-m->sn_col[t])*nr_t;
+          for (int i=0; i<len; ++i) tc[loc[rows[w+c+i]]] -= u[i];
+        }
+        c0 = c1;
+      }
+    }
+  }
+
+  void Supernodal::solve(void* mem, double* x, int nrhs, bool tr) const {
+    auto m = static_cast<SupernodalMemory*>(mem);
+    int n = m->ncol(), ns = m->sn_col.size()-1;
+    double* y = get_ptr(m->w);
+    const double* lx = get_ptr(m->lx);
+
+    // The matrix is symmetric, tr has no effect
+    for (int r=0; r<nrhs; ++r) {
+      // Permute the right-hand side
+      for (int k=0; k<n; ++k) y[k] = x[m->perm[k]];
+
+      // Forward substitution, L*y = b
+      for (int s=0; s<ns; ++s) {
+        int f = m->sn_col[s], w = m->sn_col[s+1] - f;
+        int nr = m->sn_rowind[s+1] - m->sn_rowind[s];
+        const int* rows = get_ptr(m->sn_row) + m->sn_rowind[s];
+        const double* L = lx + m->sn_off[s];
+        for (int j=0; j<w; ++j) {
+          const double* cj = L + j*nr;
+          double yj = y[f+j] /= cj[j];
+          for (int i=j+1; i<nr; ++i) y[rows[i]] -= cj[i]*yj;
+        }
+      }
+
+      // Backward substitution, L'*x = y
+      for (int s=ns-1; s>=0; --s) {
+        int f = m->sn_col[s], w = m->sn_col[s+1] - f;
+        int nr = m->sn_rowind[s+1] - m->sn_rowind[s];
+        const int* rows = get_ptr(m->sn_row) + m->sn_rowind[s];
+        const double* L = lx + m->sn_off[s];
+        for (int j=w-1; j>=0; --j) {
+          const double* cj = L + j*nr;
+          double yj = y[f+j];
+          for (int i=j+1; i<nr; ++i) yj -= cj[i]*y[rows[i]];
+          y[f+j] = yj/cj[j];
+        }
+      }
+
+      // Permute back
+      for (int k=0; k<n; ++k) x[m->perm[k]] = y[k];
+      x += n;
+    }
+  }
+
+  int Supernodal::rank(void* mem) const {
+    auto m = static_cast<SupernodalMemory*>(mem);
+    return m->ncol();
+  }
+
+} // namespace casadi
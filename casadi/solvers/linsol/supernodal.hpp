@@ -0,0 +1,139 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifndef CASADI_SUPERNODAL_HPP
+#define CASADI_SUPERNODAL_HPP
+
+#include "casadi/core/function/linsol_internal.hpp"
+#include <casadi/solvers/linsol/casadi_linsol_supernodal_export.h>
+
+/** \defgroup plugin_Linsol_supernodal
+
+       Linsol based on a supernodal sparse Cholesky factorization with
+       fill-reducing ordering. The matrix must be symmetric positive definite.
+*/
+
+/** \pluginsection{Linsol,supernodal} */
+
+/// \cond INTERNAL
+
+namespace casadi {
+
+  /** \brief Memory for Supernodal  */
+  struct CASADI_LINSOL_SUPERNODAL_EXPORT SupernodalMemory : public LinsolMemory {
+    // Fill-reducing (and postordered) permutation
+    std::vector<int> perm;
+
+    // Supernode of each column
+    std::vector<int> col_sn;
+
+    // First column of each supernode
+    std::vector<int> sn_col;
+
+    // Row structure of each supernode (offsets and rows)
+    std::vector<int> sn_rowind, sn_row;
+
+    // Offset of the dense, column-major block of each supernode in lx
+    std::vector<int> sn_off;
+
+    // Position of each nonzero of A in lx, -1 if not used
+    std::vector<int> amap;
+
+    // Nonzeros of the factor
+    std::vector<double> lx;
+
+    // Work vectors
+    std::vector<int> iw;
+    std::vector<double> w;
+  };
+
+  /** \brief \pluginbrief{Linsol,supernodal}
+
+      @copydoc Linsol_doc
+      @copydoc plugin_Linsol_supernodal
+  */
+  class CASADI_LINSOL_SUPERNODAL_EXPORT Supernodal : public LinsolInternal {
+  public:
+    // Constructor
+    Supernodal(const std::string& name);
+
+    // Destructor
+    virtual ~Supernodal();
+
+    // Get name of the plugin
+    virtual const char* plugin_name() const { return "supernodal";}
+
+    /** \brief  Create a new Linsol */
+    static LinsolInternal* creator(const std::string& name) {
+      return new Supernodal(name);
+    }
+
+    ///@{
+    /** \brief Options */
+    static Options options_;
+    virtual const Options& get_options() const { return options_;}
+    ///@}
+
+    // Initialize
+    virtual void init(const Dict& opts);
+
+    /** \brief Create memory block */
+    virtual void* alloc_memory() const { return new SupernodalMemory();}
+
+    /** \brief Free memory block */
+    virtual void free_memory(void *mem) const { delete static_cast<SupernodalMemory*>(mem);}
+
+    /** \brief Initalize memory block */
+    virtual void init_memory(void* mem) const;
+
+    // Set sparsity pattern, symbolic factorization
+    virtual void reset(void* mem, const int* sp) const;
+
+    // Factorize the linear system
+    virtual void factorize(void* mem, const double* A) const;
+
+    // Solve the linear system
+    virtual void solve(void* mem, double* x, int nrhs, bool tr) const;
+
+    /// Use a Cholesky factorization for batched dense systems
+    virtual bool batch_cholesky() const { return true;}
+
+    /// Number of negative eigenvalues
+    virtual int neig(void* mem) const { return 0;}
+
+    /// Matrix rank
+    virtual int rank(void* mem) const;
+
+    /// A documentation string
+    static const std::string meta_doc;
+
+    // Use approximate minimum degree ordering
+    bool amd_;
+  };
+
+} // namespace casadi
+
+/// \endcond
+#endif // CASADI_SUPERNODAL_HPP
@@ -56,7 +56,7 @@ namespace casadi {
   }
 
   Options SymbolicQr::options_
-  = {{&FunctionInternal::options_},
+  = {{&LinsolInternal::options_},
     {{"codegen",
       {OT_BOOL,
        "C-code generation"}},
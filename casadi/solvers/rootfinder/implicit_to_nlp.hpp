@@ -87,7 +87,10 @@ namespace casadi {
     virtual void* alloc_memory() const { return new ImplicitToNlpMemory();}
 
     /** \brief Free memory block */
-    virtual void free_memory(void *mem) const { delete static_cast<ImplicitToNlpMemory*>(mem);}
+    virtual void free_memory(void *mem) const {
+      Rootfinder::free_memory(mem);
+      delete static_cast<ImplicitToNlpMemory*>(mem);
+    }
 
     /** \brief Set the (persistent) work vectors */
     virtual void set_work(void* mem, const double**& arg, double**& res,
@@ -155,8 +155,8 @@ namespace casadi {
       }
 
       // Factorize the linear solver with J
-      linsol_.factorize(m->jac);
-      linsol_.solve(m->f, 1, false);
+      linsol_.factorize(m->jac, m->linsol_mem);
+      linsol_.solve(m->f, 1, false, m->linsol_mem);
 
       // Check convergence again
       double abstolStep=0;
@@ -93,7 +93,10 @@ namespace casadi {
     virtual void init_memory(void* mem) const;
 
     /** \brief Free memory block */
-    virtual void free_memory(void *mem) const { delete static_cast<NewtonMemory*>(mem);}
+    virtual void free_memory(void *mem) const {
+      Rootfinder::free_memory(mem);
+      delete static_cast<NewtonMemory*>(mem);
+    }
 
     /** \brief Set the (persistent) work vectors */
     virtual void set_work(void* mem, const double**& arg, double**& res,
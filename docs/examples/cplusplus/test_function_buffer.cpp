@@ -0,0 +1,80 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "casadi/casadi.hpp"
+
+using namespace casadi;
+using namespace std;
+
+/**
+ * Repeated evaluation of a function with FunctionBuffer, checked against
+ * Function::operator(). Returns a nonzero exit code on failure.
+ */
+int main() {
+  // A function with two inputs and two outputs
+  SX x = SX::sym("x", 3), p = SX::sym("p");
+  Function f("f", {x, p}, {sin(x)*p + x(0), dot(x, x) - p});
+
+  // Reference, the second input being zero
+  vector<double> x_val = {0.1, 0.2, 0.3};
+  vector<DM> ref = f(vector<DM>{x_val, 0});
+
+  // The memory object that is checked out next
+  int mem = f.checkout();
+  f.release(mem);
+
+  // Evaluate with a null input (treated as zero) and a null output (skipped)
+  {
+    FunctionBuffer buf(f);
+    vector<double> r(3, 0);
+    for (int k=0; k<10; ++k) {
+      const double* arg[] = {get_ptr(x_val), 0};
+      double* res[] = {get_ptr(r), 0};
+      buf.eval(arg, res);
+      if (norm_inf(DM(r) - ref[0]).scalar() > 1e-14) {
+        cout << "FunctionBuffer::eval differs from Function::operator()" << endl;
+        return 1;
+      }
+    }
+
+    // The buffer holds its memory object
+    int mem_other = f.checkout();
+    f.release(mem_other);
+    if (mem_other==mem) {
+      cout << "Memory object not checked out by FunctionBuffer" << endl;
+      return 1;
+    }
+  }
+
+  // Once the buffer is destroyed, its memory object is available again
+  int mem_after = f.checkout();
+  f.release(mem_after);
+  if (mem_after!=mem) {
+    cout << "Memory object not released by FunctionBuffer" << endl;
+    return 1;
+  }
+
+  cout << "FunctionBuffer test passed" << endl;
+  return 0;
+}
@@ -61,6 +61,9 @@ int main(int argc, char *argv[])
   tests.push_back({"lapackqr", UNSYM});
   tests.push_back({"ma27", SYM});
   tests.push_back({"symbolicqr", UNSYM});
+  tests.push_back({"supernodal", PD});
+  tests.push_back({"ldl", SYM});
+  tests.push_back({"krylov", UNSYM});
 
   // Test all combinations
   for (auto s : {UNSYM, SYM, PD}) {
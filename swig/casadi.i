@@ -3935,6 +3935,7 @@ namespace casadi {
 %include <casadi/core/function/importer.hpp>
 %include <casadi/core/function/callback.hpp>
 %include <casadi/core/global_options.hpp>
+%include <casadi/core/profiler.hpp>
 %include <casadi/core/casadi_meta.hpp>
 %include <casadi/core/misc/integration_tools.hpp>
 %include <casadi/core/misc/nlp_builder.hpp>
@@ -0,0 +1,490 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/** \brief Benchmarks for the core evaluation and derivative paths of CasADi
+
+  Usage: casadi_benchmarks [-o results.json] [-f filter] [-t min_time]
+
+  -o  Write the results in JSON format to this file (default: casadi_benchmarks.json)
+  -f  Only run the benchmarks whose name contains this string
+  -t  Minimum total time [s] spent per benchmark (default: 0.5)
+
+  All times in the results are per call of the benchmarked operation, in seconds.
+  The models are those of the rocket and multiple shooting examples in docs/examples/cplusplus.
+*/
+
+#include <casadi/casadi.hpp>
+#include <casadi/core/node_pool.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+using namespace casadi;
+using namespace std;
+
+// Result of one benchmark
+struct BenchmarkResult {
+  string name;
+  // Number of timed samples and total number of calls
+  int n_sample, n_call;
+  // Time per call [s]
+  double t_min, t_median, t_mean;
+  // Additional, benchmark specific, numbers
+  map<string, double> info;
+};
+
+// Runs benchmarks and collects the results
+class BenchmarkSuite {
+public:
+  BenchmarkSuite(const string& filter, double min_time) : filter_(filter), min_time_(min_time) {}
+
+  // Should a benchmark be run
+  bool enabled(const string& name) const {
+    return name.find(filter_)!=string::npos;
+  }
+
+  /* Time a benchmark. Repeated calls to body are timed together until each sample
+     lasts at least 1e-4 s. Samples are collected until min_time has passed, with at least
+     three samples. If given, setup is called before each call to body, outside of the timing.
+     Returns false if the benchmark is filtered out. */
+  bool run(const string& name, const function<void()>& body,
+           const function<void()>& setup=function<void()>(),
+           const map<string, double>& info=map<string, double>()) {
+    if (!enabled(name)) return false;
+    typedef chrono::steady_clock clock;
+
+    // Warm up and calibrate the number of calls per sample
+    int n_per_sample = 1;
+    double t_call;
+    while (true) {
+      double t = 0;
+      for (int k=0; k<n_per_sample; ++k) {
+        if (setup) setup();
+        clock::time_point t0 = clock::now();
+        body();
+        t += chrono::duration<double>(clock::now()-t0).count();
+      }
+      t_call = t/n_per_sample;
+      if (t>=1e-4 || n_per_sample>=(1<<20)) break;
+      n_per_sample *= 2;
+    }
+
+    // Timed samples
+    vector<double> samples;
+    double t_total = 0;
+    while (samples.size()<3 || t_total<min_time_) {
+      double t = 0;
+      for (int k=0; k<n_per_sample; ++k) {
+        if (setup) setup();
+        clock::time_point t0 = clock::now();
+        body();
+        t += chrono::duration<double>(clock::now()-t0).count();
+      }
+      samples.push_back(t/n_per_sample);
+      t_total += t;
+      // Very slow benchmarks: three samples suffice
+      if (samples.size()>=3 && t_call>min_time_) break;
+    }
+
+    // Statistics
+    BenchmarkResult r;
+    r.name = name;
+    r.n_sample = samples.size();
+    r.n_call = samples.size()*n_per_sample;
+    r.t_mean = t_total/r.n_call;
+    sort(samples.begin(), samples.end());
+    r.t_min = samples.front();
+    r.t_median = samples[samples.size()/2];
+    r.info = info;
+    results_.push_back(r);
+
+    // Progress
+    cout << setw(50) << left << name << " " << setw(12) << right << r.t_median
+         << " s (" << r.n_call << " calls)" << endl;
+    return true;
+  }
+
+  // Add information to the last benchmark that was run
+  void add_info(const string& key, double value) {
+    if (!results_.empty()) results_.back().info[key] = value;
+  }
+
+  // Record a benchmark that could not be run
+  void skip(const string& name, const string& reason) {
+    if (!enabled(name)) return;
+    skipped_.push_back(make_pair(name, reason));
+    cout << setw(50) << left << name << " skipped: " << reason << endl;
+  }
+
+  // Write all results in JSON format
+  void write_json(ostream& s) const {
+    s << setprecision(10);
+    s << "{\n  \"casadi\": {\"version\": " << quote(CasadiMeta::version)
+      << ", \"git_revision\": " << quote(CasadiMeta::git_revision)
+      << ", \"build_type\": " << quote(CasadiMeta::build_type)
+      << ", \"compiler\": " << quote(CasadiMeta::compiler_id) << "},\n";
+    s << "  \"min_time\": " << min_time_ << ",\n";
+    s << "  \"benchmarks\": [";
+    for (int i=0; i<results_.size(); ++i) {
+      const BenchmarkResult& r = results_[i];
+      s << (i==0 ? "\n" : ",\n") << "    {\"name\": " << quote(r.name)
+        << ", \"n_sample\": " << r.n_sample << ", \"n_call\": " << r.n_call
+        << ", \"t_min\": " << r.t_min << ", \"t_median\": " << r.t_median
+        << ", \"t_mean\": " << r.t_mean;
+      for (auto&& e : r.info) s << ", " << quote(e.first) << ": " << e.second;
+      s << "}";
+    }
+    s << "\n  ],\n  \"skipped\": [";
+    for (int i=0; i<skipped_.size(); ++i) {
+      s << (i==0 ? "\n" : ",\n") << "    {\"name\": " << quote(skipped_[i].first)
+        << ", \"reason\": " << quote(skipped_[i].second) << "}";
+    }
+    s << "\n  ]\n}" << endl;
+  }
+
+private:
+  // JSON string literal
+  static string quote(const string& str) {
+    stringstream ss;
+    ss << '"';
+    for (char c : str) {
+      if (c=='"' || c=='\\') {
+        ss << '\\' << c;
+      } else if (static_cast<unsigned char>(c)<0x20) {
+        ss << ' ';
+      } else {
+        ss << c;
+      }
+    }
+    ss << '"';
+    return ss.str();
+  }
+
+  string filter_;
+  double min_time_;
+  vector<BenchmarkResult> results_;
+  vector<pair<string, string> > skipped_;
+};
+
+// Rocket integrator, Euler forward over one control interval (rocket_mx_and_sx.cpp)
+Function rocket_integrator(int nj, int nu) {
+  SX u = SX::sym("u");
+  SX s0 = SX::sym("s0"), v0 = SX::sym("v0"), m0 = SX::sym("m0");
+  SX dt = 10.0/(nj*nu);
+  SX alpha = 0.05, beta = 0.1;
+  SX s = s0, v = v0, m = m0;
+  SX dm = -dt*beta*u*u;
+  for (int j=0; j<nj; ++j) {
+    s += dt*v;
+    v += dt / m * (u - alpha * v*v);
+    m += dm;
+  }
+  return Function("integrator", {u, vertcat(s0, v0, m0)}, {vertcat(s, v, m)});
+}
+
+// Rocket single shooting NLP with nu control intervals (rocket_mx_and_sx.cpp)
+MXDict rocket_nlp(Function integrator, int nu) {
+  MX U = MX::sym("U", nu);
+  MX X = DM(vector<double>{0, 0, 1});
+  for (int k=0; k<nu; ++k) {
+    X = integrator(vector<MX>{U(k), X}).at(0);
+  }
+  return MXDict{{"x", U}, {"f", dot(U, U)}, {"g", vertcat(X(0), X(1))}};
+}
+
+// Van der Pol multiple shooting NLP with ns intervals (multiple_shooting_from_scratch.cpp)
+MXDict multiple_shooting_nlp(int ns, vector<double>& lbx, vector<double>& ubx) {
+  SX u = SX::sym("u");
+  SX r = SX::sym("r"), s = SX::sym("s");
+  SX x = vertcat(r, s);
+  SX ode = vertcat((1 - s*s)*r - s + u, r);
+  SX quad = r*r + s*s + u*u;
+  SXDict dae = {{"x", x}, {"p", u}, {"ode", ode}, {"quad", quad}};
+  Function F = integrator("integrator", "rk", dae,
+                          {{"t0", 0}, {"tf", 20./ns}, {"number_of_finite_elements", 4}});
+
+  // States and controls stacked as [x0, u0, x1, u1, ..., xN]
+  MX V = MX::sym("V", 3*ns+2);
+  lbx.assign(3*ns+2, -inf);
+  ubx.assign(3*ns+2, inf);
+  vector<MX> X, U;
+  for (int k=0; k<=ns; ++k) {
+    X.push_back(V.nz(Slice(3*k, 3*k+2)));
+    if (k<ns) {
+      U.push_back(V.nz(Slice(3*k+2, 3*k+3)));
+      lbx[3*k+2] = -0.75;
+      ubx[3*k+2] = 1;
+    }
+  }
+  // Initial and terminal state
+  lbx[0] = ubx[0] = 0;
+  lbx[1] = ubx[1] = 1;
+  lbx[3*ns] = ubx[3*ns] = 0;
+  lbx[3*ns+1] = ubx[3*ns+1] = 0;
+
+  MX J = 0;
+  vector<MX> g;
+  for (int k=0; k<ns; ++k) {
+    MXDict I_out = F(MXDict{{"x0", X[k]}, {"p", U[k]}});
+    g.push_back(I_out.at("xf") - X[k+1]);
+    J += I_out.at("qf");
+  }
+  return MXDict{{"x", V}, {"f", J}, {"g", vertcat(g)}};
+}
+
+// Create a new instance of a function, without any cached sparsity patterns or derivatives
+Function fresh(Function f) {
+  if (f.is_a("sxfunction")) {
+    return Function(f.name(), f.sx_in(), f(f.sx_in()));
+  } else {
+    return Function(f.name(), f.mx_in(), f(f.mx_in()));
+  }
+}
+
+// Scalar expression graph with about 4*n nodes
+SX graph_sx(int n) {
+  SX x = SX::sym("x"), y = SX::sym("y"), e = x;
+  for (int k=0; k<n; ++k) e = sin(e)*x + e*y;
+  return e;
+}
+
+// Numerical evaluation, without allocations, false if filtered out
+bool bench_eval(BenchmarkSuite& b, const string& name, const Function& f) {
+  if (!b.enabled(name)) return false;
+  FunctionBuffer buf(f);
+  vector<vector<double> > arg(f.n_in()), res(f.n_out());
+  vector<const double*> argp(f.n_in());
+  vector<double*> resp(f.n_out());
+  for (int i=0; i<f.n_in(); ++i) {
+    arg[i].resize(f.nnz_in(i), 0.5);
+    argp[i] = get_ptr(arg[i]);
+  }
+  for (int i=0; i<f.n_out(); ++i) {
+    res[i].resize(f.nnz_out(i));
+    resp[i] = get_ptr(res[i]);
+  }
+  map<string, double> info;
+  if (f.is_a("sxfunction") || f.is_a("mxfunction")) info["n_nodes"] = f.n_nodes();
+  return b.run(name, [&]() { buf.eval(get_ptr(argp), get_ptr(resp));}, function<void()>(), info);
+}
+
+// NLP solution with the best available solver
+void bench_nlpsol(BenchmarkSuite& b, const string& name, const MXDict& nlp, const DMDict& arg) {
+  string solver;
+  Dict opts;
+  if (has_nlpsol("ipopt")) {
+    solver = "ipopt";
+    opts = {{"ipopt.print_level", 0}, {"print_time", false}};
+  } else if (has_nlpsol("sqpmethod") && has_conic("qpoases")) {
+    solver = "sqpmethod";
+    opts = {{"qpsol", "qpoases"}, {"qpsol_options", Dict{{"printLevel", "none"}}},
+            {"print_header", false}, {"print_time", false}};
+  } else {
+    b.skip(name, "No NLP solver available");
+    return;
+  }
+  string full_name = name + "/" + solver;
+  if (!b.enabled(full_name)) return;
+  Function nlpsol_f = nlpsol("nlpsol", solver, nlp, opts);
+  if (!b.run(full_name, [&]() { nlpsol_f(arg);})) return;
+  Dict stats = nlpsol_f.stats();
+  if (stats.find("iter_count")!=stats.end()) {
+    b.add_info("iter_count", stats.at("iter_count").to_int());
+  }
+}
+
+int main(int argc, char* argv[]) {
+  // Command line
+  string out = "casadi_benchmarks.json", filter;
+  double min_time = 0.5;
+  for (int i=1; i<argc; ++i) {
+    string a = argv[i];
+    if (a=="-o" && i+1<argc) {
+      out = argv[++i];
+    } else if (a=="-f" && i+1<argc) {
+      filter = argv[++i];
+    } else if (a=="-t" && i+1<argc) {
+      min_time = atof(argv[++i]);
+    } else {
+      cerr << "Usage: " << argv[0] << " [-o results.json] [-f filter] [-t min_time]" << endl;
+      return 1;
+    }
+  }
+  BenchmarkSuite b(filter, min_time);
+
+  // Models
+  const int nu = 20;
+  Function integrator = rocket_integrator(100, nu);
+  MXDict rocket = rocket_nlp(integrator, nu);
+  Function rocket_mx("rocket", {rocket["x"]}, {rocket["f"], rocket["g"]});
+  Function rocket_sx = rocket_mx.expand();
+  vector<double> lbx, ubx;
+  MXDict ms = multiple_shooting_nlp(50, lbx, ubx);
+  Function ms_mx("ms", {ms["x"]}, {ms["f"], ms["g"]});
+
+  // Lagrangians, for Hessians
+  SX lam_sx = SX::sym("lam", 2);
+  SX U_sx = rocket_sx.sx_in(0);
+  vector<SX> fg_sx = rocket_sx(vector<SX>{U_sx});
+  Function rocket_lag_sx("rocket_lag", {U_sx, lam_sx},
+                         {fg_sx[0] + dot(lam_sx, fg_sx[1])});
+  MX lam_ms = MX::sym("lam", ms["g"].sparsity());
+  Function ms_lag("ms_lag", {ms["x"], lam_ms}, {ms["f"] + dot(lam_ms, ms["g"])});
+  Function ms_grad = ms_lag.gradient(0, 0);
+
+  // Expression graph construction and destruction, exercising the node pool
+  b.run("graph/sx/build_destroy", [&]() { graph_sx(10000);});
+
+  // Node pool used concurrently, with objects released by another thread
+  if (b.enabled("pool/threads")) {
+    const int n_threads = 4, n_obj = 10000;
+    size_t n_allocated0 = NodePool::n_allocated();
+    b.run("pool/threads", [&]() {
+        vector<vector<void*> > obj(n_threads, vector<void*>(n_obj));
+        // Allocate concurrently
+        vector<thread> t;
+        for (int i=0; i<n_threads; ++i) {
+          t.emplace_back([&, i]() {
+              for (int k=0; k<n_obj; ++k) obj[i][k] = NodePool::allocate(16 + 16*(k%4));
+            });
+        }
+        for (auto&& ti : t) ti.join();
+        // Release concurrently, each thread the objects allocated by another thread
+        t.clear();
+        for (int i=0; i<n_threads; ++i) {
+          t.emplace_back([&, i]() {
+              for (int k=0; k<n_obj; ++k) {
+                NodePool::deallocate(obj[(i+1)%n_threads][k], 16 + 16*(k%4));
+              }
+            });
+        }
+        for (auto&& ti : t) ti.join();
+      }, function<void()>(), {{"n_threads", n_threads}});
+    casadi_assert_message(NodePool::n_allocated()==n_allocated0, "Node pool out of balance");
+  }
+
+  // Numerical evaluation
+  bench_eval(b, "eval/sx/rocket_integrator", integrator);
+  bench_eval(b, "eval/sx/rocket_single_shooting", rocket_sx);
+  bench_eval(b, "eval/mx/rocket_single_shooting", rocket_mx);
+  bench_eval(b, "eval/mx/multiple_shooting", ms_mx);
+
+  // Construction of derivative functions
+  Function f;
+  b.run("jacobian/sx/rocket_single_shooting", [&]() { f.jacobian(0, 1);},
+        [&]() { f = fresh(rocket_sx);});
+  b.run("jacobian/mx/rocket_single_shooting", [&]() { f.jacobian(0, 1);},
+        [&]() { f = fresh(rocket_mx);});
+  b.run("jacobian/mx/multiple_shooting", [&]() { f.jacobian(0, 1);},
+        [&]() { f = fresh(ms_mx);});
+  b.run("hessian/sx/rocket_single_shooting", [&]() { f.hessian(0, 0);},
+        [&]() { f = fresh(rocket_lag_sx);});
+  b.run("hessian/mx/multiple_shooting", [&]() { f.hessian(0, 0);},
+        [&]() { f = fresh(ms_lag);});
+
+  // Jacobian sparsity pattern
+  b.run("sparsity_jac/sx/rocket_single_shooting", [&]() { f.sparsity_jac(0, 1);},
+        [&]() { f = fresh(rocket_sx);});
+  b.run("sparsity_jac/mx/multiple_shooting", [&]() { f.sparsity_jac(0, 1);},
+        [&]() { f = fresh(ms_mx);});
+  b.run("sparsity_hess/mx/multiple_shooting", [&]() { f.sparsity_jac(0, 0, false, true);},
+        [&]() { f = fresh(ms_grad);});
+
+  // Graph coloring
+  if (b.enabled("coloring/uni/multiple_shooting")) {
+    Sparsity sp_jac = ms_mx.sparsity_jac(0, 1);
+    b.run("coloring/uni/multiple_shooting", [&]() { sp_jac.uni_coloring();},
+          function<void()>(), {{"n_row", sp_jac.size1()}, {"n_col", sp_jac.size2()},
+                               {"nnz", sp_jac.nnz()}});
+    b.add_info("n_color", sp_jac.uni_coloring().size2());
+  }
+  if (b.enabled("coloring/star/multiple_shooting")
+      || b.enabled("coloring/star2/multiple_shooting")) {
+    Sparsity sp_hess = ms_grad.sparsity_jac(0, 0, false, true);
+    if (b.run("coloring/star/multiple_shooting", [&]() { sp_hess.star_coloring();},
+              function<void()>(), {{"n", sp_hess.size1()}, {"nnz", sp_hess.nnz()}})) {
+      b.add_info("n_color", sp_hess.star_coloring().size2());
+    }
+    if (b.run("coloring/star2/multiple_shooting", [&]() { sp_hess.star_coloring2();})) {
+      b.add_info("n_color", sp_hess.star_coloring2().size2());
+    }
+  }
+
+  // Code generation and just-in-time compilation
+  Function rocket_jac;
+  if (b.enabled("codegen/sx/rocket_single_shooting_jacobian")
+      || b.enabled("jit/sx/rocket_single_shooting_jacobian")) {
+    rocket_jac = rocket_sx.jacobian(0, 1);
+  }
+  b.run("codegen/sx/rocket_single_shooting_jacobian", [&]() {
+      CodeGenerator gen("bench");
+      gen.add(rocket_jac);
+      gen.dump();
+    });
+  if (b.enabled("jit/sx/rocket_single_shooting_jacobian")) {
+    try {
+      Importer::load_plugin("shell");
+      b.run("jit/sx/rocket_single_shooting_jacobian", [&]() {
+          Function("rocket_jac", rocket_jac.sx_in(), rocket_jac(rocket_jac.sx_in()),
+                   {{"jit", true}, {"compiler", "shell"}});
+        });
+    } catch (exception& e) {
+      b.skip("jit/sx/rocket_single_shooting_jacobian", e.what());
+    }
+  }
+
+  // Map scaling
+  for (string parallelization : {"serial", "thread"}) {
+    for (int n : {1, 4, 16, 64}) {
+      stringstream name;
+      name << "map/" << parallelization << "/" << n;
+      if (!b.enabled(name.str())) continue;
+      if (bench_eval(b, name.str(), integrator.map("map", parallelization, n))) {
+        b.add_info("n", n);
+      }
+    }
+  }
+
+  // NLP solution
+  bench_nlpsol(b, "nlpsol/rocket_single_shooting", rocket,
+               {{"lbx", -10}, {"ubx", 10}, {"x0", 0.4},
+                {"lbg", vector<double>{10, 0}}, {"ubg", vector<double>{10, 0}}});
+  bench_nlpsol(b, "nlpsol/multiple_shooting", ms,
+               {{"lbx", lbx}, {"ubx", ubx}, {"lbg", 0}, {"ubg", 0}, {"x0", 0}});
+
+  // Save results
+  ofstream json(out.c_str());
+  if (!json.good()) {
+    cerr << "Cannot open " << out << endl;
+    return 1;
+  }
+  b.write_json(json);
+  cout << "Results written to " << out << endl;
+  return 0;
+}
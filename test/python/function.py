@@ -27,6 +27,7 @@ import numpy
 import unittest
 from types import *
 from helpers import *
+import platform
 
 class Functiontests(casadiTestCase):
 
@@ -485,7 +486,7 @@ class Functiontests(casadiTestCase):
     Z = [MX.sym("z",2,2) for i in range(n)]
     V = [MX.sym("z",Sparsity.upper(3)) for i in range(n)]
 
-    for parallelization in ["serial","openmp","unroll"] if args.run_slow else ["serial"]:
+    for parallelization in ["serial","openmp","thread","unroll"] if args.run_slow else ["serial","thread"]:
         print(parallelization)
         res = fun.map(n, parallelization).call([horzcat(*x) for x in [X,Y,Z,V]])
 
@@ -509,6 +510,133 @@ class Functiontests(casadiTestCase):
 
           self.checkfunction(f,Fref,inputs=X_+Y_+Z_+V_,sparsity_mod=args.run_slow)
 
+  def test_map_batch(self):
+    x = SX.sym("x")
+    y = SX.sym("y",2)
+
+    fun = Function("f",[x,y],[sin(y*x)+2,x**2])
+
+    # Number of instances not a multiple of the batch size
+    n = 11
+    F = fun.map(n)
+
+    np.random.seed(0)
+    X_ = DM(np.random.random((1,n)))
+    Y_ = DM(np.random.random((2,n)))
+
+    res = F(X_,Y_)
+    for k in range(n):
+      resref = fun(X_[:,k],Y_[:,k])
+      for i in range(fun.n_out()):
+        self.checkarray(res[i][:,k],resref[i])
+
+  def test_map_thread(self):
+    x = SX.sym("x")
+    y = SX.sym("y",2)
+
+    fun = Function("f",[x,y],[sin(y*x)+2,x**2])
+
+    n = 13
+    np.random.seed(0)
+    X_ = DM(np.random.random((1,n)))
+    Y_ = DM(np.random.random((2,n)))
+
+    Fref = fun.map("F", "serial", n, {})
+    for n_threads in [1, 3, 20]:
+      F = fun.map("F", "thread", n, {"n_threads": n_threads})
+      self.checkfunction(F,Fref,inputs=[X_,Y_])
+
+  def test_map_thread_few_threads(self):
+    # Fewer threads than the workers of the shared thread pool
+    import multiprocessing
+    x = SX.sym("x")
+    y = SX.sym("y",2)
+    fun = Function("f",[x,y],[sin(y*x)+2,x**2])
+
+    n = 64
+    np.random.seed(0)
+    X_ = DM(np.random.random((1,n)))
+    Y_ = DM(np.random.random((2,n)))
+
+    Fref = fun.map("F", "serial", n, {})
+    resref = Fref(X_,Y_)
+    for n_threads in set([1, 2, max(1, multiprocessing.cpu_count()-1)]):
+      F = fun.map("F", "thread", n, {"n_threads": n_threads})
+      for rep in range(5):
+        res = F(X_,Y_)
+        for i in range(fun.n_out()):
+          self.checkarray(res[i],resref[i])
+
+  def test_map_thread_nested(self):
+    # Linear solves and rootfinders inside a function evaluated by several threads
+    x = MX.sym("x",2)
+    p = MX.sym("p")
+    A = vertcat(horzcat(2+p,1),horzcat(1,3+p**2))
+    y = solve(A,x,"csparse")
+    z = SX.sym("z")
+    q = SX.sym("q")
+    rf = rootfinder("rf","newton",Function("g",[z,q],[z**3+z-q]))
+    fun = Function("f",[x,p],[y,rf(0,p*sum1(y))])
+
+    n = 40
+    np.random.seed(0)
+    X_ = DM(np.random.random((2,n)))
+    P_ = DM(np.random.random((1,n)))
+
+    Fref = fun.map("F", "serial", n, {})
+    F = fun.map("F", "thread", n, {"n_threads": 4})
+    resref = Fref(X_,P_)
+    for rep in range(10):
+      res = F(X_,P_)
+      for i in range(fun.n_out()):
+        self.checkarray(res[i],resref[i])
+
+  def test_map_serial_concurrent(self):
+    # A serial map of a rootfinder, evaluated from several threads
+    z = SX.sym("z")
+    q = SX.sym("q")
+    rf = rootfinder("rf","newton",Function("g",[z,q],[z**3+z-q]))
+    F = rf.map("F","serial",5)
+    x = MX.sym("x",1,5)
+    G = Function("G",[x],[F(0,x)]).map("G","thread",8,{"n_threads":4})
+
+    np.random.seed(0)
+    Q_ = DM(np.random.random((1,40)))
+    ref = rf.map("R","serial",40)(0,Q_)
+    for rep in range(10):
+      self.checkarray(G(Q_),ref)
+
+  def test_nested_stats(self):
+    # Calls from other functions do not use memory object 0, reported by stats()
+    z = SX.sym("z")
+    q = SX.sym("q")
+    rf = rootfinder("rf","newton",Function("g",[z,q],[z**3+z-q]))
+    rf(0,1)
+    n_call = rf.stats()["n_call_jac_f_z"]
+    x = MX.sym("x")
+    F = Function("F",[x],[rf(0,x)])
+    for i in range(4): F(i)
+    self.assertEqual(rf.stats()["n_call_jac_f_z"],n_call)
+
+  @skip(platform.system()=="Windows")
+  def test_map_process(self):
+    x = SX.sym("x")
+    y = SX.sym("y",2)
+
+    fun = Function("f",[x,y],[sin(y*x)+2,x**2])
+
+    n = 13
+    np.random.seed(0)
+    X_ = DM(np.random.random((1,n)))
+    Y_ = DM(np.random.random((2,n)))
+
+    Fref = fun.map("F", "serial", n, {})
+    F = fun.map("F", "process", n, {"n_processes": 3})
+    self.checkfunction(F,Fref,inputs=[X_,Y_])
+
+    # Workers are reused
+    self.checkarray(F(X_,Y_)[1],Fref(X_,Y_)[1])
+
   @memory_heavy()
   def test_mapsum(self):
     x = SX.sym("x")
@@ -811,6 +939,213 @@ class Functiontests(casadiTestCase):
     for sf,sF in zip(scheme_out_fun,scheme_out_F):
       self.assertTrue(sf==sF)
 
+  def test_just_in_time_native(self):
+    x = SX.sym("x")
+    y = SX.sym("y",2)
+
+    f = Function("f",[x,y],[sin(y*x)-x/y[0]+sqrt(x)*y,-x**2,fmax(x,y[1])])
+    if platform.machine()!="x86_64": return
+    F = Function("f",[x,y],[sin(y*x)-x/y[0]+sqrt(x)*y,-x**2,fmax(x,y[1])],{"just_in_time_native":True})
+
+    self.checkfunction(F,f,inputs=[0.3,DM([0.7,0.2])])
+
+  def test_memoize(self):
+    x = SX.sym("x")
+    y = SX.sym("y",2)
+
+    f = Function("f",[x,y],[sin(x)*y, x**2])
+    F = Function("f",[x,y],[sin(x)*y, x**2],{"memoize":2})
+
+    self.checkarray(F(0.3,DM([1,2]))[0],f(0.3,DM([1,2]))[0])
+    self.checkarray(F(0.3,DM([1,2]))[1],f(0.3,DM([1,2]))[1])
+    self.checkarray(F(0.4,DM([1,2]))[0],f(0.4,DM([1,2]))[0])
+    self.assertEqual(F.stats()["n_memo_hit"],1)
+    self.assertEqual(F.stats()["n_memo_miss"],2)
+
+    # Least recently used entry is discarded
+    F(0.5,DM([1,2]))
+    F(0.3,DM([1,2]))
+    self.assertEqual(F.stats()["n_memo_hit"],1)
+    self.checkarray(F(0.5,DM([1,2]))[0],f(0.5,DM([1,2]))[0])
+    self.assertEqual(F.stats()["n_memo_hit"],2)
+
+  def test_save_load(self):
+    x = SX.sym("x",3)
+    p = SX.sym("p")
+    f = Function("f",[x,p],[sin(x)*p, dot(x,x)],["x","p"],["r","s"])
+    f.save("f.casadi")
+    g = Function.load("f.casadi")
+
+    self.assertEqual(g.name_in(),["x","p"])
+    self.assertEqual(g.name_out(),["r","s"])
+    self.assertEqual(g.n_nodes(),f.n_nodes())
+    for i in range(2):
+      self.checkarray(g([1,2,3],0.3)[i],f([1,2,3],0.3)[i])
+    self.checkfunction(g,f,inputs=[DM([1,2,3]),0.3])
+
+    # Only SX functions can be saved
+    X = MX.sym("x")
+    with self.assertRaises(Exception):
+      Function("F",[X],[X**2]).save("F.casadi")
+
+  def test_profiler(self):
+    x = SX.sym("x")
+    f = Function("f",[x],[sin(x)])
+    X = MX.sym("x")
+    g = Function("g",[X],[f(f(X))])
+
+    Profiler.start()
+    g(0.3)
+    Profiler.stop()
+    g(0.3)
+    stats = Profiler.stats()
+    self.assertEqual(stats["g"]["n_call"],1)
+    self.assertEqual(stats["f"]["n_call"],2)
+    self.assertTrue(stats["g"]["t_wall_self"]<=stats["g"]["t_wall"])
+
+    Profiler.save("trace.json")
+    import json
+    with open("trace.json") as trace:
+      events = json.load(trace)["traceEvents"]
+    self.assertEqual(sorted(e["name"] for e in events),["f","f","g"])
+
+    # Distinct instances with the same name are kept apart
+    f2 = Function("f",[x],[cos(x)])
+    h = Function("h",[X],[f(X)+f2(X)+f2(X)])
+    Profiler.start()
+    h(0.3)
+    Profiler.stop()
+    stats = Profiler.stats()
+    self.assertEqual(sorted(stats.keys()),["f#0","f#1","h"])
+    self.assertEqual(sorted(stats[k]["n_call"] for k in ["f#0","f#1"]),[1,2])
+    self.assertEqual(stats["f#0"]["name"],"f")
+
+  def test_sparsity_threads(self):
+    x = SX.sym("x",200)
+    e = vertcat(*[sin(x[i])*x[(7*i)%200]+x[(13*i)%200]**2 for i in range(200)])
+    X = MX.sym("x",200)
+    sp = {}
+    for hierarchical in [False, True]:
+      GlobalOptions.setHierarchicalSparsity(hierarchical)
+      for n in [1, 4]:
+        GlobalOptions.setSparsityThreads(n)
+        f = Function("f",[x],[e,dot(e,e)])
+        g = Function("g",[X],[f(sin(X))[0],f(X)[1]])
+        for F in [f, g]:
+          sp[(F.name(),hierarchical,n)] = (F.sparsity_jac(0,0), F.sparsity_jac(0,1),
+                                           F.gradient(0,1).sparsity_jac(0,0,False,True))
+    GlobalOptions.setSparsityThreads(1)
+    GlobalOptions.setHierarchicalSparsity(True)
+    for k, v in sp.items():
+      for i in range(3):
+        self.checkarray(IM(v[i],1),IM(sp[(k[0],False,1)][i],1))
+
+  def test_sparsity_width(self):
+    x = SX.sym("x",300)
+    e = vertcat(*[sin(x[i])*x[(7*i)%300]+x[(13*i)%300]**2 for i in range(300)])
+    sp = {}
+    for hierarchical in [False, True]:
+      GlobalOptions.setHierarchicalSparsity(hierarchical)
+      for n in [1, 2, 3, 8]:
+        GlobalOptions.setSparsityWidth(n)
+        f = Function("f",[x],[e,dot(e,e)])
+        m = Function("f",[x],[e]).map("m","serial",2)
+        sp[(hierarchical,n)] = (f.sparsity_jac(0,0), f.sparsity_jac(0,1),
+                                f.gradient(0,1).sparsity_jac(0,0,False,True),
+                                m.sparsity_jac(0,0))
+    GlobalOptions.setSparsityWidth(8)
+    GlobalOptions.setHierarchicalSparsity(True)
+    for k, v in sp.items():
+      for i in range(4):
+        self.checkarray(IM(v[i],1),IM(sp[(False,1)][i],1))
+
+  def test_sparsity_cache(self):
+    import tempfile, os, shutil
+    d = tempfile.mkdtemp()
+    GlobalOptions.setSparsityCache(d)
+    try:
+      x = SX.sym("x",50)
+      e = vertcat(*[x[i]*x[(3*i)%50] for i in range(50)])
+      f = Function("f",[x],[2*e])
+      f.jacobian()
+      self.assertEqual(len(os.listdir(d)),1)
+
+      # Same structure, different constants: entry is reused
+      g = Function("g",[x],[3*e])
+      self.checkarray(IM(g.sparsity_jac(),1),IM(f.sparsity_jac(),1))
+      J = Function("J",[x],[jacobian(3*e,x)])
+      self.checkarray(g.jacobian()(list(range(50)))[0],J(list(range(50))))
+      self.assertEqual(len(os.listdir(d)),1)
+
+      # Different structure: new entry
+      h = Function("h",[x],[sin(e)])
+      h.jacobian()
+      self.assertEqual(len(os.listdir(d)),2)
+
+      # Corrupt entries are replaced
+      for fn in os.listdir(d):
+        with open(os.path.join(d,fn),"wb") as fi: fi.write(b"CASADISP")
+      g = Function("g",[x],[3*e])
+      self.checkarray(IM(g.sparsity_jac(),1),IM(f.sparsity_jac(),1))
+      self.assertEqual(len(os.listdir(d)),2)
+    finally:
+      GlobalOptions.setSparsityCache("")
+      shutil.rmtree(d)
+
+  def test_hessian_coloring(self):
+    x = SX.sym("x",30)
+    f = sum1(sin(x[:-1])*x[1:]) + x[0]*sum1(x**2) + dot(x[::3],x[::3])**2
+    H = Function("f",[x],[f]).hessian()
+    F = Function("f",[x],[f],{"hessian_coloring":"acyclic"})
+    X = MX.sym("x",30)
+    G = Function("g",[X],[F(X)],{"hessian_coloring":"acyclic"})
+    for fcn in [F, G]:
+      self.checkfunction(fcn.hessian(),H,inputs=[DM(range(30))],sens_der=False,evals=False)
+    with self.assertRaises(Exception):
+      Function("f",[x],[f],{"hessian_coloring":"foo"})
+
+  def test_jacobian_bidirectional(self):
+    # Arrowhead structure: dense rows and columns defeat unidirectional coloring
+    x = SX.sym("x",60)
+    e = sin(x)*vertcat(x[1:],x[0]) + x[-1]*x
+    e[0] += sum1(cos(x))
+    J = Function("J",[x],[jacobian(e,x),e])
+    X = MX.sym("x",60)
+    for opts in [{}, {"max_num_dir": 1}]:
+      for f in [Function("f",[x],[e],opts), Function("f",[X],[Function("f",[x],[e])(X)],opts)]:
+        self.checkfunction(f.jacobian(),J,inputs=[DM(range(60))],sens_der=False,evals=False)
+
+  def test_checkout(self):
+    x = SX.sym("x")
+    f = Function("f",[x],[x**2])
+
+    # Memory objects in use are never handed out twice
+    m1 = f.checkout()
+    m2 = f.checkout()
+    self.assertTrue(m1!=m2)
+
+    # Evaluation while all memory objects are checked out
+    self.checkarray(f(3),9)
+    f.release(m1)
+    f.release(m2)
+
+    # Released objects are reused
+    self.assertTrue(f.checkout() in [m1,m2])
+
+  def test_cse(self):
+    x = SX.sym("x")
+    y = SX.sym("y",2)
+
+    # Structurally identical, but distinct expressions
+    e = [sin(x)*y+cos(x*y[0]), y*sin(x)+cos(y[0]*x), x*y[0]]
+
+    f = Function("f",[x,y],e)
+    F = Function("f",[x,y],e,{"cse":True})
+
+    self.assertTrue(F.n_nodes()<f.n_nodes())
+    self.assertEqual(F.stats()["n_cse"],f.n_nodes()-F.n_nodes())
+    self.checkfunction(F,f,inputs=[0.3,DM([0.7,0.2])])
+
   # @requiresPlugin(Importer,"clang")
   # def test_jitfunction_clang(self):
   #   x = MX.sym("x")
@@ -510,6 +510,120 @@ class LinearSolverTests(casadiTestCase):
 
         self.checkarray(mtimes(A_,f_out),b)
 
+  def test_supernodal(self):
+    load_linsol("supernodal")
+    numpy.random.seed(1)
+    for n in [1, 7, 40]:
+      R = self.randDM(n,n,sparsity=0.2)
+      A = mtimes(R.T,R) + DM.eye(n)
+      b = self.randDM(n,3)
+      for ordering in ["amd","natural"]:
+        for A_ in [A, tril(A)]:
+          C = solve(A_,b,"supernodal",{"ordering":ordering})
+          self.checkarray(mtimes(A,C),b)
+    with self.assertRaises(Exception):
+      solve(-DM.eye(3),DM.ones(3),"supernodal")
+
+  def test_ldl(self):
+    load_linsol("ldl")
+    numpy.random.seed(1)
+    for n, m in [(1, 0), (1, 1), (8, 3), (40, 15)]:
+      R = self.randDM(n,n,sparsity=0.2)
+      H = mtimes(R.T,R) + DM.eye(n)
+      J = self.randDM(m,n,sparsity=0.3) + DM.eye(n)[:m,:]
+      K = sparsify(blockcat([[H, J.T],[J, DM(m,m)]]))
+      b = self.randDM(n+m,2)
+      for ordering in ["amd","natural"]:
+        for nthreads in [1, 2]:
+          S = casadi.Linsol("S","ldl",{"ordering":ordering,"nthreads":nthreads})
+          C = S.solve(K,b)
+          self.checkarray(mtimes(K,C),b)
+          self.assertEqual(S.neig(),m)
+          self.assertEqual(S.rank(),n+m)
+    # Singular matrix
+    S = casadi.Linsol("S","ldl")
+    S.solve(DM([[1,0,0],[0,-2,0],[0,0,0]]),DM.ones(3))
+    self.assertEqual(S.neig(),1)
+    self.assertEqual(S.rank(),2)
+
+  def test_refactor(self):
+    numpy.random.seed(1)
+    n = 10
+    A = self.randDM(n,n,sparsity=0.3) + 3*DM.eye(n)
+    b = self.randDM(n,2)
+    for refactor in [True, False]:
+      S = casadi.Linsol("S","csparse",{"refactor":refactor})
+      for k in range(4):
+        A_ = A*(1+0.1*k)
+        C = S.solve(A_,b)
+        self.checkarray(mtimes(A_,C),b)
+      stats = S.stats()
+      self.assertEqual(stats["n_factorize"], 1 if refactor else 4)
+      self.assertEqual(stats["n_refactorize"], 3 if refactor else 0)
+
+    # Pivot sequence no longer stable, full factorization
+    S = casadi.Linsol("S","csparse")
+    A = DM([[1,0],[0,1]])
+    S.solve(A,DM.ones(2))
+    A = DM([[0,1],[1,0]])
+    C = S.solve(A,DM([1,2]))
+    self.checkarray(C,DM([2,1]))
+    self.assertEqual(S.stats()["n_factorize"], 2)
+
+  def test_map_solve_batch(self):
+    numpy.random.seed(1)
+    n = 5
+    N = 70
+    A = MX.sym("A",n,n)
+    b = MX.sym("b",n,2)
+    As = []
+    for i in range(N):
+      R = self.randDM(n,n)
+      As.append(mtimes(R.T,R) + DM.eye(n))
+    bs = [self.randDM(n,2) for i in range(N)]
+    for Solver in ["csparse","csparsecholesky"]:
+      for tr in [False,True]:
+        for opts in [{}, {"batch_dense_max":0}]:
+          f = Function("f",[A,b],[solve(A.T if tr else A,b,Solver,opts)])
+          F = f.map(N)
+          X = F(hcat(As),hcat(bs))
+          for i in range(N):
+            self.checkarray(X[:,2*i:2*i+2], solve(As[i].T if tr else As[i], bs[i]))
+
+  def test_krylov(self):
+    load_linsol("krylov")
+    numpy.random.seed(1)
+    n = 20
+    R = self.randDM(n,n,sparsity=0.2)
+    H = mtimes(R.T,R) + DM.eye(n)
+    A = H + self.randDM(n,n,sparsity=0.2)
+    K = H - 2*DM.eye(n)
+    b = self.randDM(n,2)
+    for method, M, pcs in [("gmres", A, ["none","jacobi","ilu0"]),
+                           ("cg", H, ["none","jacobi","ic0"]),
+                           ("minres", K, ["none","jacobi"])]:
+      for pc in pcs:
+        S = casadi.Linsol("S","krylov",{"method":method,"preconditioner":pc})
+        C = S.solve(M,b)
+        self.checkarray(mtimes(M,C),b,digits=8)
+        self.assertTrue(S.stats()["success"])
+    # Matrix-free, with the nonzeros only used for the preconditioner
+    d = SX.sym("d",Sparsity.diag(n))
+    v = SX.sym("v",n)
+    jtimes = Function("jtimes",[d,v],[mtimes(SX(H),v)])
+    S = casadi.Linsol("S","krylov",{"method":"cg","jtimes":jtimes})
+    C = S.solve(diag(diag(H)),b)
+    self.checkarray(mtimes(H,C),b,digits=8)
+    # Transposed matrix-free products by reverse mode AD
+    jtimes = Function("jtimes",[d,v],[mtimes(SX(A),v)])
+    S = casadi.Linsol("S","krylov",{"method":"gmres","jtimes":jtimes})
+    C = S.solve(diag(diag(A)),b,True)
+    self.checkarray(mtimes(A.T,C),b,digits=8)
+    # Not converged
+    S = casadi.Linsol("S","krylov",{"method":"cg","max_iter":1})
+    S.solve(H,b)
+    self.assertFalse(S.stats()["success"])
+
   def test_dimmismatch(self):
     A = DM.eye(5)
     b = DM.ones((4,1))
@@ -471,6 +471,30 @@ class Sparsitytests(casadiTestCase):
 
     self.assertTrue(DM(J.sparsity_out(0))[:X.nnz(),:].sparsity()==Sparsity.diag(100))
 
+  def test_acyclic_coloring(self):
+    numpy.random.seed(0)
+    sp = self.randDM(40,40,0.1,symm=True).sparsity() + Sparsity.diag(40)
+    D = sp.acyclic_coloring()
+    color = [0]*40
+    for c in range(D.size2()):
+      for i in D.row()[D.colind()[c]:D.colind()[c+1]]:
+        color[i] = c
+    # Distance-1 coloring
+    for i,j in zip(sp.row(),sp.get_col()):
+      if i!=j: self.assertTrue(color[i]!=color[j])
+    # Each pair of colors induces a forest
+    for a in range(D.size2()):
+      for b in range(a):
+        parent = list(range(40))
+        def find(i):
+          while parent[i]!=i: i = parent[i]
+          return i
+        for i,j in zip(sp.row(),sp.get_col()):
+          if i<j and set([color[i],color[j]])==set([a,b]):
+            self.assertTrue(find(i)!=find(j))
+            parent[find(i)] = find(j)
+    self.assertTrue(D.size2()<=sp.star_coloring().size2())
+
   def test_rowcol(self):
     n = 3
 
@@ -510,6 +534,19 @@ class Sparsitytests(casadiTestCase):
 
     self.checkarray(IM(c_,1),IM(c.kron(a,b).sparsity(),1))
 
+  def test_cache_stats(self):
+    Sparsity.cache_reset_stats()
+    a = Sparsity.lower(137)
+    self.assertEqual(Sparsity.cache_misses(),1)
+    self.assertEqual(Sparsity.cache_hits(),0)
+    size = Sparsity.cache_size()
+    b = Sparsity.lower(137)
+    self.assertEqual(Sparsity.cache_hits(),1)
+    self.assertEqual(Sparsity.cache_size(),size)
+    self.assertTrue(a==b)
+    del a, b
+    self.assertEqual(Sparsity.cache_size(),size-1)
+
 if __name__ == '__main__':
     unittest.main()
 
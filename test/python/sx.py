@@ -1057,6 +1057,23 @@ class SXtests(casadiTestCase):
 
     self.checkarray(h_out[0].nonzeros(),H.nonzeros())
 
+  def test_hess_edge_pushing(self):
+    x = SX.sym("x",5)
+    p = SX.sym("p")
+    for e in [x[0]*x[1]*x[2]+sin(x[3])*x[4]/x[1],
+              exp(x[0]**2)+log(x[1])+x[2]**x[3]+sqrt(x[4])*p,
+              atan2(x[0],x[1])+fmax(x[2],x[3])*fmin(x[3],x[4]),
+              sq(x[0]+x[1])+tanh(x[2])*atan(x[3])+1/x[4],
+              dot(x,x)**2,
+              -x[2]/(2+sq(sq(x[3])))]:
+      f = Function("f",[x,p],[e])
+      H = SX.hess(f)
+      H_ref = hessian(e,x)[0]
+      self.assertTrue(H.sparsity()==H_ref.sparsity())
+      h = Function("h",[x,p],[H,H_ref])
+      H_out, H_ref_out = h([0.3,0.7,1.2,0.4,0.9],2)
+      self.checkarray(H_out,H_ref_out)
+
   def test_mxnulloutput(self):
      a = SX(5,0)
      b = SX.sym("x",2)